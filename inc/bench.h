@@ -0,0 +1,38 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<bench.h>>
+
+#pragma once
+
+#include "defs.h"
+
+#ifndef BENCH_MAX_SAMPLES
+# define BENCH_MAX_SAMPLES	1048576
+#endif
+
+typedef struct {
+	u64			messages;
+	u64			frames;
+	atomic u64	bytes;
+	u64			rx_at;
+	u64			rtt;
+	i64			offset;
+	u64			playout;
+	f64			skew_sum;
+	f32			skew_max;
+	u64			skew_count;
+	u32			*samples;
+	u64			sample_count;
+}	bench_stats;
+
+extern bench_stats	bench;
+
+u8		bench_run(void);
+void	bench_report(void);
+void	bench_frame(const u64 now);
+void	bench_skew(const f32 skew);
@@ -0,0 +1,35 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<bot.h>>
+
+#pragma once
+
+#include "data.h"
+
+#define BOT_STOP	0x0U
+#define BOT_UP		0x1U
+#define BOT_DOWN	0x2U
+
+#ifndef BOT_DEADBAND
+# define BOT_DEADBAND	0.5f
+#endif
+
+typedef struct {
+	struct {
+		f32	x;
+		f32	y;
+	}	ball;
+	f32	slope;
+	i8	heading;
+	u8	side;
+	u8	direction;
+	u8	primed;
+}	bot;
+
+void	bot_init(bot *pilot, const u8 side);
+u8		bot_update(bot *pilot, const msg_srv_state *state);
@@ -13,25 +13,48 @@
 
 #define MESSAGE_HEADER_SIZE	4
 
+// state datagrams are a u32 sequence number followed by a regular message
+#define MESSAGE_UDP_SEQ_SIZE	4
+
 #define MESSAGE_CLIENT_START		0
 #define MESSAGE_CLIENT_PAUSE		1
 #define MESSAGE_CLIENT_MOVE_PADDLE	2
 #define MESSAGE_CLIENT_QUIT			3
+#define MESSAGE_CLIENT_PING			4
 
 #define MESSAGE_SERVER_GAME_INIT	0
 #define MESSAGE_SERVER_GAME_PAUSED	1
 #define MESSAGE_SERVER_GAME_OVER	2
 #define MESSAGE_SERVER_STATE_UPDATE	3
+#define MESSAGE_SERVER_PONG			4
+
+// paddle speed of the reference server, in field units per second
+#define GAME_PADDLE_SPEED	9.0f
 
 #define GAME_OVER_ACT_WON		0x1U
 #define GAME_OVER_ACT_QUIT		0x2U
 #define GAME_OVER_SERVER_CLOSED	0x3U
 
+#define STATE_V2_P1		0x01U
+#define STATE_V2_P2		0x02U
+#define STATE_V2_BALL_X	0x04U
+#define STATE_V2_BALL_Y	0x08U
+#define STATE_V2_SCORE	0x10U
+#define STATE_V2_ALL	0x1FU
+
+// v2 positions are i16 fixed point in units of 1 / STATE_V2_SCALE
+#define STATE_V2_SCALE	256.0f
+
+// servers without a udp state channel stop after p2_port
 typedef struct [[gnu::packed]] {
 	u16	p1_port;
 	u16	p2_port;
+	u16	udp_port;
+	u32	udp_token;
 }	msg_srv_init;
 
+#define MESSAGE_SERVER_INIT_SIZE	offsetof(msg_srv_init, udp_port)
+
 typedef struct [[gnu::packed]] {
 	u8	winner_id;
 }	msg_srv_game_over_v0;
@@ -57,10 +80,26 @@ typedef struct [[gnu::packed]] __msg_srv_state {
 	u16	score;
 }	msg_srv_state;
 
+typedef struct [[gnu::packed]] __msg_srv_state_v2 {
+	u8	flags;
+	u8	fields[4 * sizeof(i16) + sizeof(u16)];
+}	msg_srv_state_v2;
+
+// timestamps are CLOCK_REALTIME nanoseconds, each taken on the side that sets it
+typedef struct [[gnu::packed]] {
+	u64	sent;
+	u64	received;
+	u64	replied;
+}	msg_srv_pong;
+
 typedef struct [[gnu::packed]] __msg_clt_move_paddle {
 	u8	direction;
 }	msg_clt_move_paddle;
 
+typedef struct [[gnu::packed]] {
+	u64	sent;
+}	msg_clt_ping;
+
 typedef struct [[gnu::packed]] {
 	u8	version;
 	u8	type;
@@ -69,6 +108,9 @@ typedef struct [[gnu::packed]] {
 		msg_srv_init		init;
 		msg_srv_game_over	game_over;
 		msg_srv_state		state;
+		msg_srv_state_v2	state_v2;
+		msg_srv_pong		pong;
 		msg_clt_move_paddle	move_paddle;
+		msg_clt_ping		ping;
 	}	body;
 }	message;
@@ -16,6 +16,8 @@
 # define PROG_NAME	"netpong"
 #endif
 
+#define atomic	_Atomic
+
 typedef	int8_t		i8;
 typedef	int16_t		i16;
 typedef	int32_t		i32;
@@ -22,3 +22,5 @@ u8	display_game(const game *game);
 u8	display_menu(const menu *menu);
 u8	display_msg(const char **msg);
 u8	init_display(void);
+
+void	update_display_size(void);
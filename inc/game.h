@@ -11,6 +11,11 @@
 
 #include "defs.h"
 
+#define PLAY_REMATCH	0x2U
+
+#define GAME_BOT_P1	0x1U
+#define GAME_BOT_P2	0x2U
+
 typedef struct {
 	f32	p1_pos;
 	f32	p2_pos;
@@ -18,6 +23,7 @@ typedef struct {
 		f32	x;
 		f32	y;
 	}	ball;
+	u32	rtt;
 	u8	p1_score;
 	u8	p2_score;
 	u8	started;
@@ -27,5 +33,19 @@ typedef struct {
 	u8	over;
 }	game;
 
+typedef struct {
+	const char	*record;
+	const char	*replay;
+	f32			speed;
+	u8			bench;
+	u8			bot;
+	u8			udp;
+}	game_opts;
+
+extern game_opts	game_options;
+
 u8	setup_game_binds(void);
 u8	play(void);
+
+u8		prewarm_start(void);
+void	game_shutdown(void);
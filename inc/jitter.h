@@ -0,0 +1,39 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<jitter.h>>
+
+#pragma once
+
+#include "game.h"
+
+#ifndef JITTER_SLOTS
+# define JITTER_SLOTS	64
+#endif
+
+#define JITTER_MAX_DELAY_DEFAULT	150
+#define JITTER_MAX_DELAY_LIMIT		500
+
+typedef struct {
+	struct {
+		game	state;
+		u64		arrival;
+		u64		at;
+	}	slots[JITTER_SLOTS];
+	u64	interval;
+	u64	jitter;
+	u64	delay;
+	u64	max_delay;
+	u64	playout;
+	u32	head;
+	u32	count;
+}	jitter_buffer;
+
+void	jitter_init(jitter_buffer *buf, const u64 max_delay);
+void	jitter_reset(jitter_buffer *buf);
+void	jitter_push(jitter_buffer *buf, const game *state, const u64 now);
+u8		jitter_sample(jitter_buffer *buf, game *frame, const u64 now);
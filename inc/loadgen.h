@@ -0,0 +1,22 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<loadgen.h>>
+
+#pragma once
+
+#include "defs.h"
+
+#ifndef LOADGEN_SESSIONS_MAX
+# define LOADGEN_SESSIONS_MAX	65536
+#endif
+
+#ifndef LOADGEN_TICK_HZ
+# define LOADGEN_TICK_HZ	10
+#endif
+
+u8	loadgen_run(const char *addr, const char *port, const u32 sessions);
@@ -11,6 +11,8 @@
 
 #include "defs.h"
 
+#define MENU_COLOR_COUNT	256
+
 typedef struct __menu_item	menu_item;
 typedef struct __menu		menu;
 
@@ -51,6 +53,8 @@ struct __menu {
 	u8			width;
 };
 
+extern const char	*color_codes[MENU_COLOR_COUNT];
+
 u8	main_menu(const char *server_addr, const char *server_port);
 
 void	cleanup(void);
@@ -0,0 +1,77 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<mock.h>>
+
+#pragma once
+
+#include <sys/socket.h>
+
+#include "data.h"
+
+#define MOCK_PATTERN_STEADY	0x0U
+#define MOCK_PATTERN_BURST	0x1U
+
+#ifndef MOCK_BURST_SIZE
+# define MOCK_BURST_SIZE	16
+#endif
+
+typedef struct {
+	u32	rate;
+	u32	duration;
+	u32	burst;
+	u32	stall_every;
+	u32	stall_ms;
+	u32	close_after;
+	u8	max_score;
+	u8	version;
+	u8	pattern;
+	u8	udp;
+	u8	loss;
+}	mock_config;
+
+typedef struct {
+	mock_config	config;
+	i32			listen[3];
+	i32			clients[3];
+	u16			ports[3];
+	i32			stop;
+	i32			udp;
+	u64			sent;
+	struct {
+		f32	x;
+		f32	y;
+		f32	dx;
+		f32	dy;
+	}			ball;
+	f32			paddles[2];
+	u8			scores[2];
+	u8			inputs[2];
+	u8			human;
+	u8			paused;
+	u8			status;
+	u8			actor;
+	u8			rx[2][MESSAGE_HEADER_SIZE + sizeof(msg_clt_ping)];
+	u8			rx_len[2];
+	i16			quantized[4];
+	u16			score;
+	u8			version;
+	u8			primed;
+	struct {
+		struct sockaddr_storage	peer;
+		socklen_t				len;
+		u32						token;
+		u32						seq;
+		u32						rng;
+		u8						ready;
+	}			datagram;
+}	mock_server;
+
+u8		mock_init(mock_server *srv, const mock_config *config, const char *addr, const u16 port);
+u8		mock_run(mock_server *srv);
+void	mock_stop(mock_server *srv);
+void	mock_close(mock_server *srv);
@@ -0,0 +1,120 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<net.h>>
+
+#pragma once
+
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include "data.h"
+
+#define NET_PROTOCOL_VERSION	2
+// oldest protocol version that answers MESSAGE_CLIENT_PING
+#define NET_PING_VERSION		2
+
+#ifndef NET_RX_BUFFER_SIZE
+# define NET_RX_BUFFER_SIZE	16384
+#endif
+
+#ifndef NET_TX_BATCH
+# define NET_TX_BATCH	16
+#endif
+
+#ifndef NET_ADDRS_MAX
+# define NET_ADDRS_MAX	8
+#endif
+
+#ifndef NET_CONNECT_MAX
+# define NET_CONNECT_MAX	2
+#endif
+
+#ifndef NET_CONNECT_STAGGER_MS
+# define NET_CONNECT_STAGGER_MS	250
+#endif
+
+#ifndef NET_CLOCK_WINDOW
+# define NET_CLOCK_WINDOW	8
+#endif
+
+#ifndef NET_UDP_HELLO_COUNT
+# define NET_UDP_HELLO_COUNT	3
+#endif
+
+typedef struct {
+	char					host[NI_MAXHOST];
+	struct sockaddr_storage	addrs[NET_ADDRS_MAX];
+	socklen_t				lens[NET_ADDRS_MAX];
+	u8						count;
+}	net_addrs;
+
+typedef struct {
+	u8				buf[NET_RX_BUFFER_SIZE];
+	size_t			head;
+	size_t			tail;
+	size_t			skip;
+	msg_srv_state	base;
+	message			state;
+}	net_rx;
+
+typedef struct {
+	net_rx	rx;
+	u64		dropped;
+	u32		seq;
+	u32		token;
+	i32		socket;
+	u8		primed;
+}	net_udp;
+
+typedef struct {
+	struct {
+		u64	rtt;
+		i64	offset;
+	}		window[NET_CLOCK_WINDOW];
+	u64		rtt;
+	u64		rtt_var;
+	i64		offset;
+	u64		samples;
+}	net_clock;
+
+typedef struct {
+	message	msgs[NET_TX_BATCH];
+	u8		out[2 * NET_TX_BATCH * sizeof(message)];
+	size_t	out_len;
+	u8		count;
+}	net_tx;
+
+u8	net_resolve(net_addrs *addrs, const char *host);
+u16	net_port(const char *port);
+u8	net_connect(const net_addrs *addrs, const u16 *ports, i32 *sockets, const u8 n, const u64 timeout_ns);
+i32	net_connect_start(const net_addrs *addrs, const u8 i, const u16 port);
+
+void	net_rx_reset(net_rx *rx);
+
+u8		*net_rx_space(net_rx *rx, size_t *room);
+void	net_rx_commit(net_rx *rx, const size_t n);
+ssize_t	net_rx_fill(net_rx *rx, const i32 socket, const i32 flags);
+
+const message	*net_rx_next(net_rx *rx, const u8 version);
+
+void	net_init_body(const message *msg, msg_srv_init *init);
+
+u8				net_udp_open(net_udp *udp, const i32 peer, const u16 port, const u32 token);
+u8				net_udp_hello(net_udp *udp);
+const message	*net_udp_next(net_udp *udp, const u8 version);
+void			net_udp_close(net_udp *udp);
+
+void	net_clock_reset(net_clock *clock);
+u8		net_clock_sample(net_clock *clock, const msg_srv_pong *pong, const u64 now);
+
+void	net_tx_reset(net_tx *tx);
+void	net_tx_consume(net_tx *tx, const u8 n);
+
+u8	net_tx_push(net_tx *tx, const message *msg);
+i8	net_tx_flush(net_tx *tx, const i32 socket);
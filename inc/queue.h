@@ -0,0 +1,35 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<queue.h>>
+
+#pragma once
+
+#include "data.h"
+
+#ifndef QUEUE_SIZE
+# define QUEUE_SIZE	64
+#endif
+
+typedef struct {
+	u8		player;
+	message	msg;
+}	command;
+
+typedef struct {
+	struct {
+		atomic u64	seq;
+		command		cmd;
+	}			slots[QUEUE_SIZE];
+	atomic u64	head;
+	atomic u64	tail;
+}	cmd_queue;
+
+void	queue_init(cmd_queue *queue);
+
+u8	queue_push(cmd_queue *queue, const command *cmd);
+u8	queue_pop(cmd_queue *queue, command *cmd);
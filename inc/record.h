@@ -0,0 +1,78 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<record.h>>
+
+#pragma once
+
+#include <stddef.h>
+#include <pthread.h>
+
+#include "data.h"
+
+#ifndef RECORD_BUFFER_SIZE
+# define RECORD_BUFFER_SIZE	262144
+#endif
+
+#ifndef RECORD_KEYFRAME_INTERVAL
+# define RECORD_KEYFRAME_INTERVAL	128
+#endif
+
+#define RECORD_MAGIC		"NPRC"
+#define RECORD_INDEX_MAGIC	"NPRI"
+#define RECORD_VERSION		2
+
+typedef struct [[gnu::packed]] {
+	u64	at;
+	u64	offset;
+}	record_key;
+
+typedef struct {
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t		tid;
+	u8				buf[RECORD_BUFFER_SIZE];
+	size_t			head;
+	size_t			tail;
+	u64				start;
+	u64				last;
+	u64				offset;
+	u64				dropped;
+	msg_srv_state	base;
+	record_key		*index;
+	u32				index_count;
+	u32				index_cap;
+	u32				since_key;
+	i32				fd;
+	u8				key_due;
+	u8				stop;
+}	recorder;
+
+typedef struct {
+	const u8			*map;
+	const record_key	*index;
+	record_key			*scanned;
+	size_t				size;
+	size_t				end;
+	size_t				pos;
+	message				msg;
+	msg_srv_state		base;
+	u64					at;
+	u32					index_count;
+	u8					version;
+	u8					pending;
+}	replay;
+
+u8		record_open(recorder *rec, const char *path);
+void	record_push(recorder *rec, const message *msg);
+void	record_close(recorder *rec);
+
+u8				replay_open(replay *rp, const char *path);
+const message	*replay_peek(replay *rp, u64 *at);
+void			replay_skip(replay *rp);
+void			replay_seek(replay *rp, const u64 at);
+void			replay_close(replay *rp);
@@ -0,0 +1,74 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<uring.h>>
+
+#pragma once
+
+#include <linux/io_uring.h>
+
+#include "defs.h"
+
+#ifndef URING_ENTRIES
+# define URING_ENTRIES	32
+#endif
+
+#ifndef URING_BUF_COUNT
+# define URING_BUF_COUNT	16
+#endif
+
+#ifndef URING_BUF_SIZE
+# define URING_BUF_SIZE		4096
+#endif
+
+#define URING_SEND_SLOTS		32
+#define URING_SEND_SLOT_SIZE	64
+
+typedef u8	(*uring_recv_fn)(const void *data, const i32 n);
+
+typedef struct {
+	i32				fd;
+	i32				recv_socket;
+	u32				queued;
+	struct {
+		u32					*head;
+		u32					*tail;
+		u32					*mask;
+		u32					*array;
+		struct io_uring_sqe	*sqes;
+		size_t				sqes_size;
+	}				sq;
+	struct {
+		u32					*head;
+		u32					*tail;
+		u32					*mask;
+		struct io_uring_cqe	*cqes;
+	}				cq;
+	struct {
+		struct io_uring_buf_ring	*ring;
+		u8							*data;
+		u16							tail;
+	}				bufs;
+	struct {
+		u8	data[URING_SEND_SLOTS][URING_SEND_SLOT_SIZE];
+		u32	used;
+		u8	failed;
+	}				send;
+	void			*ring;
+	size_t			ring_size;
+	u8				registered;
+	u8				received;
+	u8				unsupported;
+}	uring;
+
+u8		uring_init(uring *ring);
+void	uring_close(uring *ring);
+
+u8	uring_recv(uring *ring, const i32 socket);
+u8	uring_send(uring *ring, const i32 socket, const void *buf, const size_t n);
+u8	uring_submit(uring *ring);
+u8	uring_reap(uring *ring, uring_recv_fn fn);
@@ -9,12 +9,13 @@
 
 #pragma once
 
-#include <stdio.h>
-
 #include "defs.h"
 
 char	*utoa16(u16 n, char *buf);
 
-i32	fputc_utf8(const u32 cp, FILE *stream);
+u8	utf8_encode(const u32 cp, char buf[4]);
 
 f32	roundf_f(const f32 n, const f32 factor);
+
+u64	time_ns(void);
+u64	wall_ns(void);
@@ -0,0 +1,211 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<bench.c>>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+
+#include "mock.h"
+#include "game.h"
+#include "bench.h"
+#include "utils.h"
+#include "display.h"
+
+#define _BENCH_ADDR		"127.0.0.1"
+#define _BENCH_COLS		120
+#define _BENCH_ROWS		40
+
+#define _RATE_DEFAULT		120
+#define _RATE_MAX			100000
+#define _SECONDS_DEFAULT	10
+
+extern struct {
+	const char	*addr;
+	const char	*port;
+}	server_info;
+
+bench_stats	bench;
+
+static struct {
+	mock_config	config;
+	u64			elapsed;
+}	run;
+
+static void	*_serve(void *arg);
+static void	*_sink(void *arg);
+static u8	_config(mock_config *config);
+static u8	_redirect(i32 *master, i32 *saved);
+static void	_restore(const i32 saved);
+
+static i32	_cmp(const void *a, const void *b);
+
+u8	bench_run(void) {
+	mock_server	srv;
+	pthread_t	server;
+	pthread_t	sink;
+	char		port[6];
+	u64			start;
+	i32			master;
+	i32			saved;
+	u8			rv;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.samples = malloc(BENCH_MAX_SAMPLES * sizeof(*bench.samples));
+	if (!bench.samples || !_config(&run.config) || !mock_init(&srv, &run.config, _BENCH_ADDR, 0)) {
+		free(bench.samples);
+		return 0;
+	}
+	server_info.addr = _BENCH_ADDR;
+	server_info.port = utoa16(srv.ports[0], port);
+	if (pthread_create(&server, NULL, _serve, &srv) != 0) {
+		mock_close(&srv);
+		free(bench.samples);
+		return 0;
+	}
+	rv = _redirect(&master, &saved) && pthread_create(&sink, NULL, _sink, &master) == 0;
+	start = time_ns();
+	if (rv)
+		rv = play() != 0;
+	start = time_ns() - start;
+	mock_stop(&srv);
+	pthread_join(server, NULL);
+	mock_close(&srv);
+	if (saved != -1) {
+		_restore(saved);
+		pthread_join(sink, NULL);
+		close(master);
+	}
+	run.elapsed = start;
+	return rv;
+}
+
+void	bench_frame(const u64 now) {
+	bench.frames++;
+	if (!bench.rx_at)
+		return ;
+	if (bench.sample_count < BENCH_MAX_SAMPLES)
+		bench.samples[bench.sample_count++] = ((now - bench.rx_at) / 1000 < UINT32_MAX) ? (now - bench.rx_at) / 1000 : UINT32_MAX;
+	bench.rx_at = 0;
+}
+
+// distance between a drawn paddle and the played-out state the ball comes from
+void	bench_skew(const f32 skew) {
+	bench.skew_sum += skew;
+	bench.skew_count++;
+	if (skew > bench.skew_max)
+		bench.skew_max = skew;
+}
+
+static void	*_serve(void *arg) {
+	mock_run(arg);
+	return NULL;
+}
+
+static void	*_sink(void *arg) {
+	u8		buf[65536];
+	ssize_t	n;
+
+	while ((n = read(*(i32 *)arg, buf, sizeof(buf))) > 0 || (n == -1 && errno == EINTR))
+		if (n > 0)
+			bench.bytes += n;
+	return NULL;
+}
+
+static u8	_config(mock_config *config) {
+	const char	*tmp;
+	u64			n;
+
+	tmp = getenv("NETPONG_BENCH_RATE");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 0;
+	config->rate = (n && n <= _RATE_MAX) ? n : _RATE_DEFAULT;
+	tmp = getenv("NETPONG_BENCH_SECONDS");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 0;
+	config->duration = (n && n <= UINT16_MAX) ? n : _SECONDS_DEFAULT;
+	tmp = getenv("NETPONG_BENCH_VERSION");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 1;
+	config->version = (n <= 2) ? n : 1;
+	config->udp = game_options.udp;
+	tmp = getenv("NETPONG_BENCH_PATTERN");
+	config->pattern = (tmp && strcmp(tmp, "burst") == 0) ? MOCK_PATTERN_BURST : MOCK_PATTERN_STEADY;
+	return (!tmp || strcmp(tmp, "burst") == 0 || strcmp(tmp, "steady") == 0) ? 1 : 0;
+}
+
+static u8	_redirect(i32 *master, i32 *saved) {
+	struct winsize	size;
+	i32				unlock;
+	i32				slave;
+
+	*saved = -1;
+	*master = open("/dev/ptmx", O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (*master == -1)
+		return 0;
+	unlock = 0;
+	slave = (ioctl(*master, TIOCSPTLCK, &unlock) != -1) ? ioctl(*master, TIOCGPTPEER, O_RDWR | O_NOCTTY | O_CLOEXEC) : -1;
+	size = (struct winsize){.ws_row = _BENCH_ROWS, .ws_col = _BENCH_COLS};
+	if (slave == -1 || ioctl(slave, TIOCSWINSZ, &size) == -1 || fflush(stdout) == EOF) {
+		if (slave != -1)
+			close(slave);
+		close(*master);
+		return 0;
+	}
+	*saved = dup(STDOUT_FILENO);
+	if (*saved == -1 || dup2(slave, STDOUT_FILENO) == -1) {
+		if (*saved != -1)
+			close(*saved);
+		*saved = -1;
+		close(slave);
+		close(*master);
+		return 0;
+	}
+	close(slave);
+	update_display_size();
+	return 1;
+}
+
+static void	_restore(const i32 saved) {
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+	update_display_size();
+}
+
+void	bench_report(void) {
+	f64	seconds;
+	u64	p50;
+	u64	p99;
+
+	seconds = (f64)run.elapsed / 1000000000.0;
+	qsort(bench.samples, bench.sample_count, sizeof(*bench.samples), _cmp);
+	p50 = (bench.sample_count) ? bench.samples[bench.sample_count / 2] : 0;
+	p99 = (bench.sample_count) ? bench.samples[bench.sample_count * 99 / 100] : 0;
+	fprintf(stdout, "%s bench: v%hhu %s %u msg/s for %u s\n", PROG_NAME, run.config.version,
+		(run.config.pattern == MOCK_PATTERN_BURST) ? "burst" : "steady", run.config.rate, run.config.duration);
+	fprintf(stdout, "  messages/s     %.1f\n", bench.messages / seconds);
+	fprintf(stdout, "  frames/s       %.1f\n", bench.frames / seconds);
+	fprintf(stdout, "  bytes/frame    %.1f\n", (bench.frames) ? (f64)bench.bytes / bench.frames : 0.0);
+	fprintf(stdout, "  latency p50    %lu us\n", p50);
+	fprintf(stdout, "  latency p99    %lu us\n", p99);
+	fprintf(stdout, "  rtt            %lu us\n", bench.rtt / 1000);
+	fprintf(stdout, "  clock offset   %ld us\n", bench.offset / 1000);
+	fprintf(stdout, "  playout delay  %lu us\n", bench.playout / 1000);
+	fprintf(stdout, "  paddle skew    %.3f avg %.3f max\n", (bench.skew_count) ? bench.skew_sum / bench.skew_count : 0.0,
+		(f64)bench.skew_max);
+	fflush(stdout);
+	free(bench.samples);
+	bench.samples = NULL;
+}
+
+static i32	_cmp(const void *a, const void *b) {
+	return (*(const u32 *)a > *(const u32 *)b) - (*(const u32 *)a < *(const u32 *)b);
+}
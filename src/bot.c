@@ -0,0 +1,70 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<bot.c>>
+
+#include <math.h>
+
+#include "bot.h"
+
+#define _FIELD_X	40.0f
+#define _FIELD_Y	20.0f
+
+static inline f32	_reflect(const f32 y);
+
+void	bot_init(bot *pilot, const u8 side) {
+	*pilot = (bot){
+		.side = side,
+		.direction = BOT_STOP
+	};
+}
+
+u8	bot_update(bot *pilot, const msg_srv_state *state) {
+	const i8	toward = (pilot->side) ? 1 : -1;
+	f32			target;
+	f32			pos;
+	f32			dx;
+	f32			dy;
+	u8			direction;
+
+	dx = state->ball.x - pilot->ball.x;
+	dy = state->ball.y - pilot->ball.y;
+	// a jump across the field is a serve, not movement
+	if (!pilot->primed || fabsf(dx) > _FIELD_X / 2 || fabsf(dy) > _FIELD_Y / 2)
+		pilot->heading = 0;
+	else if (dx != 0.0f) {
+		pilot->heading = (dx > 0.0f) ? 1 : -1;
+		pilot->slope = dy / dx;
+	}
+	pilot->ball.x = state->ball.x;
+	pilot->ball.y = state->ball.y;
+	pilot->primed = 1;
+	target = _FIELD_Y / 2;
+	if (pilot->heading == toward)
+		target = _reflect(state->ball.y + pilot->slope * (((pilot->side) ? _FIELD_X : 0.0f) - state->ball.x));
+	pos = (pilot->side) ? state->p2_paddle : state->p1_paddle;
+	if (target > pos + BOT_DEADBAND)
+		direction = BOT_UP;
+	else if (target < pos - BOT_DEADBAND)
+		direction = BOT_DOWN;
+	else
+		direction = BOT_STOP;
+	if (direction == pilot->direction)
+		return 0;
+	pilot->direction = direction;
+	return 1;
+}
+
+// unfold the path into a straight line, then fold it back between the walls
+static inline f32	_reflect(const f32 y) {
+	f32	folded;
+
+	folded = fmodf(y, 2 * _FIELD_Y);
+	if (folded < 0.0f)
+		folded += 2 * _FIELD_Y;
+	return (folded > _FIELD_Y) ? 2 * _FIELD_Y - folded : folded;
+}
@@ -8,18 +8,29 @@
 // <<display.c>>
 
 #include <math.h>
+#include <poll.h>
+#include <errno.h>
 #include <stdio.h>
 #include <signal.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <sys/ioctl.h>
 
+#ifdef __SSE2__
+# include <immintrin.h>
+#endif
+
 #include "utils.h"
 #include "display.h"
 
-#define set_color_fg(x)	(fprintf(stdout, "\x1b[38;5;%hhum", (u8)x))
-#define set_color_bg(x)	(fprintf(stdout, "\x1b[48;5;%hhum", (u8)x))
+#define _SGR_RESET	"\x1b[m"
+#define _CLEAR		"\x1b[2J"
+
+#ifndef DISPLAY_ARENA_SIZE
+# define DISPLAY_ARENA_SIZE	16384
+#endif
 
 #define _BOX_SIDE_HORIZONTAL	0x2501U
 #define _BOX_SIDE_VERTICAL		0x2503U
@@ -41,7 +52,7 @@
 #define _BALL_BL	0x2819U
 #define _BALL_BR	0x280BU
 
-#define _WIN_TOO_SMALL	"\x1b[2J[WINDOW TOO SMALL]"
+#define _WIN_TOO_SMALL	_CLEAR "[WINDOW TOO SMALL]"
 
 #define _COLORS_FG_DEFAULT				231
 #define _COLORS_SELECTION_FG_DEFAULT	16
@@ -61,6 +72,64 @@ struct {
 	u8	edge;
 }	colors;
 
+typedef struct {
+	u32	cp;
+	i16	fg;
+	i16	bg;
+}	_cell;
+
+typedef struct {
+	char	seq[12];
+	u8		len;
+}	_sgr_code;
+
+// the playfield cells and positions that only change with the window size
+static struct {
+	_cell	*cells;
+	u32		width;
+	u32		height;
+	u32		root[2];
+	u32		score[2];
+	i16		edge;
+}	_board;
+
+// encoded bytes of a box, replayed while its geometry and color hold
+typedef struct {
+	char	*data;
+	size_t	len;
+	u32		key[4];
+	i16		edge;
+}	_box_layer;
+
+static _box_layer	_menu_box;
+static _box_layer	_msg_box;
+
+// bytes of the frame being assembled, written out all at once
+static struct {
+	char	*data;
+	size_t	len;
+	size_t	cap;
+}	_out;
+
+// colors the terminal is currently drawing with, -1 being the default
+static struct {
+	_sgr_code	fg[MENU_COLOR_COUNT];
+	_sgr_code	bg[MENU_COLOR_COUNT];
+	i16			current[2];
+}	_sgr = {
+	.current = {-1, -1}
+};
+
+// cells of the frame being drawn and of the one on screen
+static struct {
+	_cell	*cells[2];
+	u32		width;
+	u32		height;
+	u8		front;
+	u8		drawing;
+	u8		valid;
+}	_frame;
+
 struct {
 	struct {
 		u32	cells;
@@ -72,11 +141,26 @@ struct {
 	}	height;
 }	window_size;
 
+static inline u8	_out_reserve(const size_t n);
+static inline u8	_out_write(const void *data, const size_t n);
+static inline u8	_out_puts(const char *s);
+static inline u8	_out_utf8(const u32 cp);
+static inline u8	_out_flush(void);
+
 static inline u8	_move_to(const u32 x, const u32 y);
+static inline u8	_set_sgr(const i16 fg, const i16 bg);
 static inline u8	_putc_at(const u32 x, const u32 y, const i16 hl[2], const i32 cp);
 static inline u8	_puts_at(const u32 x, const u32 y, const i16 hl[2], const char *s);
 static inline u8	_printf_at(const u32 x, const u32 y, const i16 hl[2], const char *fmt, ...);
 
+static inline u8	_frame_begin(void);
+static inline u8	_frame_flush(void);
+static inline void	_frame_put(const u32 x, const u32 y, const i16 hl[2], const u32 cp);
+static inline u32	_row_diff(const _cell *a, const _cell *b, u32 i, const u32 n);
+static inline u8	_emit_cell(const _cell *cell);
+
+static inline u8	_build_board(const u16 width, const u16 height);
+static inline u8	_put_box(_box_layer *layer, const u32 x, const u32 y, const u32 width, const u32 height);
 static inline u8	_draw_box(const u32 root_x, const u32 root_y, const u32 width, const u32 height);
 
 static inline u8	_draw_paddle(const f32 paddle_pos, const u32 root_x, const u32 root_y, const u32 offset);
@@ -94,27 +178,30 @@ u8	display_game(const game *game) {
 	static const u16	width = 40 + 2;
 	static const u16	height = 20;
 	static u8			too_small_printed = 0;
-	u32					root_x;
-	u32					root_y;
-	u32					score_x;
-	u32					score_y;
+	const u32			*root;
 
 	if (window_size.width.cells < (u32)width + 2 || window_size.height.cells < (u32)height + 2) {
+		_frame.valid = 0;
 		if (!too_small_printed)
-			too_small_printed = (_puts_at(1, 1, (i16[2]){196, -1}, _WIN_TOO_SMALL) && fflush(stdout) != EOF) ? DISPLAY_GAME_WIN_TOO_SMALL : 0;
+			too_small_printed = (_puts_at(1, 1, (i16[2]){196, -1}, _WIN_TOO_SMALL) && _set_sgr(-1, -1) && _out_flush()) ? DISPLAY_GAME_WIN_TOO_SMALL : 0;
 		return too_small_printed;
 	}
 	too_small_printed = 0;
-	_calculate_top_left_xy((u32*[2]){&root_x, &root_y}, width, height);
-	fputs("\x1b[2J", stdout);
-	_draw_box(root_x - 1, root_y - 1, width + 2, height + 2);
-	_draw_paddle(height - game->p1_pos, root_x, root_y, 0);
-	_draw_paddle(height - game->p2_pos, root_x, root_y, width - 1);
-	_draw_ball((f32[2]){game->ball.x, height - game->ball.y}, root_x, root_y);
-	score_y = height + 2;
-	score_x = (width - 8) / 2;
-	_printf_at(root_x + score_x, root_y + score_y, (i16[2]){-1, -1}, "%-3hhu--%3hhu", game->p1_score, game->p2_score);
-	return (fflush(stdout) != EOF) ? 1 : 0;
+	if (!_frame_begin())
+		return 0;
+	if (_board.width != _frame.width || _board.height != _frame.height || _board.edge != colors.edge || !_board.cells) {
+		if (!_build_board(width, height))
+			return 0;
+	} else
+		memcpy(_frame.cells[!_frame.front], _board.cells, _frame.width * _frame.height * sizeof(*_board.cells));
+	root = _board.root;
+	_draw_paddle(height - game->p1_pos, root[0], root[1], 0);
+	_draw_paddle(height - game->p2_pos, root[0], root[1], width - 1);
+	_draw_ball((f32[2]){game->ball.x, height - game->ball.y}, root[0], root[1]);
+	_printf_at(_board.score[0], _board.score[1], (i16[2]){-1, -1}, "%-3hhu--%3hhu", game->p1_score, game->p2_score);
+	if (game->rtt)
+		_printf_at(root[0] + width - 8, _board.score[1], (i16[2]){-1, -1}, "%6.1fms", game->rtt / 1000.0);
+	return (_frame_flush() && _set_sgr(-1, -1) && _out_flush()) ? 1 : 0;
 }
 
 u8	display_menu(const menu *menu) {
@@ -132,6 +219,7 @@ u8	display_menu(const menu *menu) {
 	u16				max_visible_y;
 
 
+	_frame.valid = 0;
 	menu_width = menu->width * (menu->longest_title + 2);
 	menu_height = menu->height;
 	if (((menu_width + 2) * 100) / window_size.width.cells > 100 - DISPLAY_MENU_MIN_MARGIN * 2) {
@@ -153,9 +241,8 @@ u8	display_menu(const menu *menu) {
 		return _scroll_menu(menu, max_visible_x, max_visible_y);
 	else {
 		_calculate_top_left_xy((u32*[2]){&root_x, &root_y}, menu_width, menu_height);
-		fputs("\x1b[2J", stdout);
-		_draw_box(root_x - 1, root_y - 1, menu_width + 2, menu_height + 2);
-		if (!_move_to(root_x, root_y++))
+		if (!_out_puts(_CLEAR) || !_put_box(&_menu_box, root_x - 1, root_y - 1, menu_width + 2, menu_height + 2)
+			|| !_move_to(root_x, root_y++))
 			return 0;
 		for (current = menu->root; current; current = down) {
 			for (down = current->neighbors.down; current; current = current->neighbors.right) {
@@ -163,11 +250,11 @@ u8	display_menu(const menu *menu) {
 				if (!_pad(padding.left))
 					return 0;
 				if (current->selected) {
-					if (set_color_fg(colors.selection.fg) == -1 || set_color_bg(colors.selection.bg) == -1)
+					if (!_set_sgr(colors.selection.fg, colors.selection.bg))
 						return 0;
-				} else if (set_color_fg(colors.fg) == -1)
+				} else if (!_set_sgr(colors.fg, -1))
 					return 0;
-				if (fprintf(stdout, " %s \x1b[m", current->title) == -1)
+				if (!_out_write(" ", 1) || !_out_puts(current->title) || !_out_write(" ", 1))
 					return 0;
 				if (!_pad(padding.right))
 					return 0;
@@ -176,7 +263,7 @@ u8	display_menu(const menu *menu) {
 				return 0;
 		}
 	}
-	return fflush(stdout) != EOF;
+	return _set_sgr(-1, -1) && _out_flush();
 }
 
 u8	display_msg(const char **msg) {
@@ -190,6 +277,7 @@ u8	display_msg(const char **msg) {
 	u32		root_x;
 	u32		root_y;
 
+	_frame.valid = 0;
 	for (width = height = 0; msg[height]; height++) {
 		if (strlen(msg[height]) > width)
 			width = strlen(msg[height]);
@@ -198,7 +286,7 @@ u8	display_msg(const char **msg) {
 	if (window_size.width.cells < (u32)width + 2 || window_size.height.cells < (u32)height + 2)
 		return 1;
 	_calculate_top_left_xy((u32*[2]){&root_x, &root_y}, width, height);
-	if (!_draw_box(root_x - 1, root_y - 1, width + 2, height + 2))
+	if (!_put_box(&_msg_box, root_x - 1, root_y - 1, width + 2, height + 2))
 		return 0;
 	if (!_move_to(root_x, root_y++))
 		return 0;
@@ -206,18 +294,16 @@ u8	display_msg(const char **msg) {
 		_calculate_padding(&padding.left, &padding.right, width, strlen(msg[i]));
 		if (!_pad(padding.left))
 			return 0;
-		if (!set_color_fg(colors.fg))
+		if (!_set_sgr(colors.fg, -1))
 			return 0;
-		if (fputs(msg[i], stdout) == EOF)
+		if (!_out_puts(msg[i]))
 			return 0;
 		if (!_pad(padding.right))
 			return 0;
 		if (!_move_to(root_x, root_y++))
 			return 0;
 	}
-	if (!fputs("\x1b[m", stdout))
-		return 0;
-	return fflush(stdout) != EOF;
+	return _set_sgr(-1, -1) && _out_flush();
 }
 
 u8	init_display(void) {
@@ -225,6 +311,12 @@ u8	init_display(void) {
 	const char			*tmp;
 	u64					n;
 
+	for (n = 0; n < MENU_COLOR_COUNT; n++) {
+		_sgr.fg[n].len = snprintf(_sgr.fg[n].seq, sizeof(_sgr.fg[n].seq), "\x1b[38;5;%sm", color_codes[n]);
+		_sgr.bg[n].len = snprintf(_sgr.bg[n].seq, sizeof(_sgr.bg[n].seq), "\x1b[48;5;%sm", color_codes[n]);
+	}
+	if (!_out_reserve(DISPLAY_ARENA_SIZE))
+		return 0;
 	memset(&action, 0, sizeof(action));;
 	action.sa_handler = _update_window_size;
 	if (sigaction(SIGWINCH, &action, NULL) == -1)
@@ -251,50 +343,278 @@ u8	init_display(void) {
 	return 1;
 }
 
-static inline u8	_move_to(const u32 x, const u32 y) {
-	return (fprintf(stdout, "\x1b[%u;%uH", y, x) != -1) ? 1 : 0;
+void	update_display_size(void) {
+	_update_window_size(0);
 }
 
-static inline u8	_putc_at(const u32 x, const u32 y, const i16 hl[2], const i32 cp) {
-	if (!_move_to(x, y))
+static inline u8	_out_reserve(const size_t n) {
+	char	*data;
+	size_t	cap;
+
+	if (_out.len + n <= _out.cap)
+		return 1;
+	for (cap = (_out.cap) ? _out.cap : DISPLAY_ARENA_SIZE; cap < _out.len + n; cap *= 2)
+		;
+	data = realloc(_out.data, cap);
+	if (!data)
 		return 0;
-	if (hl[0] != -1 && set_color_fg(hl[0]) == -1)
+	_out.data = data;
+	_out.cap = cap;
+	return 1;
+}
+
+static inline u8	_out_write(const void *data, const size_t n) {
+	if (!_out_reserve(n))
 		return 0;
-	if (hl[1] != -1 && set_color_bg(hl[1]) == -1)
+	memcpy(_out.data + _out.len, data, n);
+	_out.len += n;
+	return 1;
+}
+
+static inline u8	_out_puts(const char *s) {
+	return _out_write(s, strlen(s));
+}
+
+static inline u8	_out_utf8(const u32 cp) {
+	if (!_out_reserve(4))
 		return 0;
-	if (fputc_utf8(cp, stdout) == EOF)
+	_out.len += utf8_encode(cp, _out.data + _out.len);
+	return 1;
+}
+
+// stdout shares its file description with the tty input, so it may be non-blocking
+static inline u8	_out_flush(void) {
+	struct pollfd	pfd;
+	size_t			done;
+	ssize_t			n;
+
+	for (done = 0; done < _out.len; ) {
+		n = write(STDOUT_FILENO, _out.data + done, _out.len - done);
+		if (n > 0)
+			done += n;
+		else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			pfd = (struct pollfd){.fd = STDOUT_FILENO, .events = POLLOUT};
+			if (poll(&pfd, 1, -1) == -1 && errno != EINTR)
+				break ;
+		} else if (n == 0 || errno != EINTR)
+			break ;
+	}
+	n = (done == _out.len) ? 1 : 0;
+	_out.len = 0;
+	return n;
+}
+
+static inline u8	_move_to(const u32 x, const u32 y) {
+	char	buf[6];
+
+	return _out_write("\x1b[", 2) && _out_puts(utoa16(y, buf)) && _out_write(";", 1)
+		&& _out_puts(utoa16(x, buf)) && _out_write("H", 1);
+}
+
+static inline u8	_set_sgr(const i16 fg, const i16 bg) {
+	// colors can only be dropped all at once
+	if ((fg == -1 && _sgr.current[0] != -1) || (bg == -1 && _sgr.current[1] != -1)) {
+		if (!_out_write(_SGR_RESET, sizeof(_SGR_RESET) - 1))
+			return 0;
+		_sgr.current[0] = _sgr.current[1] = -1;
+	}
+	if (fg != _sgr.current[0]) {
+		if (!_out_write(_sgr.fg[(u8)fg].seq, _sgr.fg[(u8)fg].len))
+			return 0;
+		_sgr.current[0] = fg;
+	}
+	if (bg != _sgr.current[1]) {
+		if (!_out_write(_sgr.bg[(u8)bg].seq, _sgr.bg[(u8)bg].len))
+			return 0;
+		_sgr.current[1] = bg;
+	}
+	return 1;
+}
+
+static inline u8	_putc_at(const u32 x, const u32 y, const i16 hl[2], const i32 cp) {
+	if (_frame.drawing) {
+		_frame_put(x, y, hl, cp);
+		return 1;
+	}
+	if (!_move_to(x, y) || !_set_sgr(hl[0], hl[1]))
 		return 0;
-	return fputs("\x1b[m", stdout) != EOF;
+	return _out_utf8(cp);
 }
 
 static inline u8	_puts_at(const u32 x, const u32 y, const i16 hl[2], const char *s) {
-	if (!_move_to(x, y))
-		return 0;
-	if (hl[0] != -1 && set_color_fg(hl[0]) == -1)
-		return 0;
-	if (hl[1] != -1 && set_color_bg(hl[1]) == -1)
-		return 0;
-	if (fputs(s, stdout) == EOF)
+	if (!_move_to(x, y) || !_set_sgr(hl[0], hl[1]))
 		return 0;
-	return fputs("\x1b[m", stdout) != EOF;
+	return _out_puts(s);
 }
 
 static inline u8	_printf_at(const u32 x, const u32 y, const i16 hl[2], const char *fmt, ...) {
 	va_list	args;
 	ssize_t	rv;
+	char	buf[64];
 
-	if (!_move_to(x, y))
+	va_start(args, fmt);
+	rv = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+	if (rv < 0)
 		return 0;
-	if (hl[0] != -1 && set_color_fg(hl[0]) == -1)
+	if (!_frame.drawing)
+		return _puts_at(x, y, hl, buf);
+	for (rv = 0; buf[rv]; rv++)
+		_frame_put(x + rv, y, hl, (u8)buf[rv]);
+	return 1;
+}
+
+static inline u8	_frame_begin(void) {
+	const _cell	blank = {.cp = ' ', .fg = -1, .bg = -1};
+	_cell		*cells;
+	u32			n;
+	u32			i;
+	u8			j;
+
+	if (_frame.width != window_size.width.cells || _frame.height != window_size.height.cells || !_frame.cells[0]) {
+		n = window_size.width.cells * window_size.height.cells;
+		for (j = 0; j < 2; j++) {
+			cells = realloc(_frame.cells[j], n * sizeof(*cells));
+			if (!cells)
+				return 0;
+			_frame.cells[j] = cells;
+		}
+		_frame.width = window_size.width.cells;
+		_frame.height = window_size.height.cells;
+		_frame.valid = 0;
+	}
+	n = _frame.width * _frame.height;
+	// the screen may hold anything, so clear it and diff against blanks
+	if (!_frame.valid) {
+		if (!_out_puts(_CLEAR))
+			return 0;
+		for (i = 0; i < n; i++)
+			_frame.cells[_frame.front][i] = blank;
+		_frame.valid = 1;
+	}
+	_frame.drawing = 1;
+	return 1;
+}
+
+static inline u8	_frame_flush(void) {
+	const _cell	*next;
+	const _cell	*prev;
+	u32			cursor[2];
+	u32			x;
+	u32			y;
+
+	_frame.drawing = 0;
+	next = _frame.cells[!_frame.front];
+	prev = _frame.cells[_frame.front];
+	cursor[0] = cursor[1] = UINT32_MAX;
+	for (y = 0; y < _frame.height; y++, next += _frame.width, prev += _frame.width) {
+		for (x = _row_diff(next, prev, 0, _frame.width); x < _frame.width; x = _row_diff(next, prev, x + 1, _frame.width)) {
+			if ((x != cursor[0] || y != cursor[1]) && !_move_to(x + 1, y + 1))
+				return 0;
+			if (!_emit_cell(&next[x]))
+				return 0;
+			cursor[0] = x + 1;
+			cursor[1] = y;
+		}
+	}
+	_frame.front = !_frame.front;
+	return 1;
+}
+
+static inline void	_frame_put(const u32 x, const u32 y, const i16 hl[2], const u32 cp) {
+	if (x < 1 || y < 1 || x > _frame.width || y > _frame.height)
+		return ;
+	_frame.cells[!_frame.front][(y - 1) * _frame.width + x - 1] = (_cell){
+		.cp = cp,
+		.fg = hl[0],
+		.bg = hl[1]
+	};
+}
+
+// index of the first cell from i on that differs between the two rows
+static inline u32	_row_diff(const _cell *a, const _cell *b, u32 i, const u32 n) {
+#ifdef __AVX2__
+	u32	mask;
+
+	for (; i + 4 <= n; i += 4) {
+		mask = ~(u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(a + i)),
+			_mm256_loadu_si256((const __m256i *)(b + i))));
+		if (mask)
+			return i + __builtin_ctz(mask) / sizeof(*a);
+	}
+#endif
+#ifdef __SSE2__
+	u32	bits;
+
+	for (; i + 2 <= n; i += 2) {
+		bits = ~(u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)),
+			_mm_loadu_si128((const __m128i *)(b + i)))) & 0xFFFFU;
+		if (bits)
+			return i + __builtin_ctz(bits) / sizeof(*a);
+	}
+#endif
+	for (; i < n; i++)
+		if (a[i].cp != b[i].cp || a[i].fg != b[i].fg || a[i].bg != b[i].bg)
+			return i;
+	return n;
+}
+
+static inline u8	_emit_cell(const _cell *cell) {
+	// blanks only care about the background
+	if (!_set_sgr((cell->cp == ' ') ? _sgr.current[0] : cell->fg, cell->bg))
 		return 0;
-	if (hl[1] != -1 && set_color_bg(hl[1]) == -1)
+	return _out_utf8(cell->cp);
+}
+
+static inline u8	_build_board(const u16 width, const u16 height) {
+	const _cell	blank = {.cp = ' ', .fg = -1, .bg = -1};
+	_cell		*cells;
+	u32			n;
+	u32			i;
+
+	n = _frame.width * _frame.height;
+	cells = realloc(_board.cells, n * sizeof(*cells));
+	if (!cells)
 		return 0;
-	va_start(args, fmt);
-	rv = vfprintf(stdout, fmt, args);
-	va_end(args);
-	if (rv == -1)
+	_board.cells = cells;
+	cells = _frame.cells[!_frame.front];
+	for (i = 0; i < n; i++)
+		cells[i] = blank;
+	_calculate_top_left_xy((u32*[2]){&_board.root[0], &_board.root[1]}, width, height);
+	_board.score[0] = _board.root[0] + (width - 8) / 2;
+	_board.score[1] = _board.root[1] + height + 2;
+	_draw_box(_board.root[0] - 1, _board.root[1] - 1, width + 2, height + 2);
+	memcpy(_board.cells, cells, n * sizeof(*cells));
+	_board.width = _frame.width;
+	_board.height = _frame.height;
+	_board.edge = colors.edge;
+	return 1;
+}
+
+static inline u8	_put_box(_box_layer *layer, const u32 x, const u32 y, const u32 width, const u32 height) {
+	const u32	key[4] = {x, y, width, height};
+	size_t		start;
+	char		*data;
+
+	// the bytes assume the default colors going in and leave the edge color set
+	if (!_set_sgr(-1, -1))
+		return 0;
+	if (layer->data && layer->edge == colors.edge && !memcmp(layer->key, key, sizeof(key))) {
+		_sgr.current[0] = colors.edge;
+		return _out_write(layer->data, layer->len);
+	}
+	start = _out.len;
+	if (!_draw_box(x, y, width, height))
 		return 0;
-	return fputs("\x1b[m", stdout) != EOF;
+	data = realloc(layer->data, _out.len - start);
+	if (!data)
+		return 0;
+	memcpy(data, _out.data + start, _out.len - start);
+	layer->data = data;
+	layer->len = _out.len - start;
+	memcpy(layer->key, key, sizeof(key));
+	layer->edge = colors.edge;
+	return 1;
 }
 
 static inline u8	_draw_box(const u32 root_x, const u32 root_y, const u32 width, const u32 height) {
@@ -473,9 +793,8 @@ static inline u8	_scroll_menu(const menu *menu, const u16 max_visible_x, const u
 	menu_width = max_visible_x * (longest_title + 2);
 	menu_height = max_visible_y;
 	_calculate_top_left_xy((u32*[2]){&root_x, &root_y}, menu_width, menu_height);
-	fputs("\x1b[2J", stdout);
-	_draw_box(root_x - 1, root_y - 1, menu_width + 2, menu_height + 2);
-	if (!_move_to(root_x, root_y++))
+	if (!_out_puts(_CLEAR) || !_put_box(&_menu_box, root_x - 1, root_y - 1, menu_width + 2, menu_height + 2)
+		|| !_move_to(root_x, root_y++))
 		return 0;
 	for (current = start, i = 0; i < max_visible_y; i++) {
 		for (down = current->neighbors.down, j = 0; j < max_visible_x; j++) {
@@ -483,11 +802,11 @@ static inline u8	_scroll_menu(const menu *menu, const u16 max_visible_x, const u
 			if (!_pad(padding.left))
 				return 0;
 			if (current->selected) {
-				if (set_color_fg(colors.selection.fg) == -1 || set_color_bg(colors.selection.bg) == -1)
+				if (!_set_sgr(colors.selection.fg, colors.selection.bg))
 					return 0;
-			} else if (set_color_fg(colors.fg) == -1)
+			} else if (!_set_sgr(colors.fg, -1))
 				return 0;
-			if (fprintf(stdout, " %s \x1b[m", current->title) == -1)
+			if (!_out_write(" ", 1) || !_out_puts(current->title) || !_out_write(" ", 1))
 				return 0;
 			if (!_pad(padding.right))
 				return 0;
@@ -497,13 +816,16 @@ static inline u8	_scroll_menu(const menu *menu, const u16 max_visible_x, const u
 			return 0;
 		current = down;
 	}
-	return fflush(stdout) != EOF;
+	return _set_sgr(-1, -1) && _out_flush();
 }
 
 static inline u8	_pad(size_t n) {
-	while (n--)
-		if (fputc(' ', stdout) == EOF)
-			return 0;
+	if (n && _sgr.current[1] != -1 && !_set_sgr(-1, -1))
+		return 0;
+	if (!_out_reserve(n))
+		return 0;
+	memset(_out.data + _out.len, ' ', n);
+	_out.len += n;
 	return 1;
 }
 
@@ -7,33 +7,103 @@
 //
 // <<game.c>>
 
+#include <math.h>
 #include <errno.h>
-#include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <limits.h>
 #include <signal.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
 #include <kbinput/kbinput.h>
 
+#include "bot.h"
+#include "net.h"
 #include "data.h"
+#include "bench.h"
+#include "jitter.h"
+#include "queue.h"
+#include "record.h"
 #include "game.h"
+#include "uring.h"
 #include "utils.h"
 #include "display.h"
 
-#define atomic	_Atomic
-
 #define _SIGS	kb_io_listener.sigs.set
 
 #define _GAME_FIELD_X	40.0f
 #define _GAME_FIELD_Y	20.0f
 
+#define _REACTOR_MAX_EVENTS		8
+#define _SERVER_TIMEOUT_DEFAULT	10
+
+#define _PING_INTERVAL_DEFAULT	1000
+#define _CONNECT_TIMEOUT_DEFAULT	5
+
+#define _PREWARM_TTL_DEFAULT	30
+#define _PREWARM_BACKOFF_MIN	1000
+#define _PREWARM_BACKOFF_MAX	30000
+
+#define _FPS_DEFAULT	60
+#define _FPS_MAX		1000
+
+#define _PADDLE_HALF_HEIGHT		1.5f
+#define _PADDLE_SPEED_DEFAULT	GAME_PADDLE_SPEED
+
+#define _PREDICT_TAU		0.15f
+#define _PREDICT_MAX_DT		0.1f
+#define _PREDICT_EPSILON	0.01f
+#define _PREDICT_HISTORY	16
+
+#define _EVENT_STATE	0x0U
+#define _EVENT_P1		0x1U
+#define _EVENT_P2		0x2U
+#define _EVENT_SIGNAL	0x3U
+#define _EVENT_TIMER	0x4U
+#define _EVENT_URING	0x5U
+#define _EVENT_COMMAND	0x6U
+#define _EVENT_REPLAY	0x7U
+#define _EVENT_UDP		0x8U
+#define _EVENT_CONTROL	0x9U
+
+#define _EVENT_HANGUP	(EPOLLRDHUP | EPOLLHUP | EPOLLERR)
+
 #define _MSG_GAME_OVER			"Game over"
 #define _MSG_GAME_OVER_P1_WON	"Player 1 wins"
 #define _MSG_GAME_OVER_P2_WON	"Player 2 wins"
 #define _MSG_SERVER_CLOSED		"Server closed"
 #define _MSG_P1_QUIT			"Player 1 quit"
 #define _MSG_P2_QUIT			"Player 2 quit"
+#define _MSG_DISMISS			"[r] rematch  [enter] menu"
+
+#define _GAME_OVER_WAIT	5
+
+#define _REPLAY_TOGGLE	0x0U
+#define _REPLAY_STEP	0x1U
+#define _REPLAY_BACK	0x2U
+#define _REPLAY_FORWARD	0x3U
+#define _REPLAY_QUIT	0x4U
+#define _REPLAY_OPS		5
+#define _REPLAY_JUMP_NS	10000000000UL
+
+// replay keys count presses in a field of the op word per op
+#define _REPLAY_OP_BITS	12
+#define _REPLAY_OP_MASK	((1UL << _REPLAY_OP_BITS) - 1)
+
+#define _KB_IO_IDLE		0x0U
+#define _KB_IO_ACTIVE	0x1U
+#define _KB_IO_STOP		0x2U
+
+#define _KB_IO_MAX_MISSES	64
 
 #define add_sig(set, sig)	((sigaddset(&set, sig) != -1) ? 1 : 0)
 
@@ -54,53 +124,144 @@ typedef enum {
 }	message_type;
 
 extern kbinput_listener_id	game_binds;
+extern kbinput_listener_id	over_binds;
+extern kbinput_listener_id	replay_binds;
 extern u8					kb_protocol;
 
-static const struct addrinfo	hints = {
-	.ai_family = AF_INET,
-	.ai_socktype = SOCK_STREAM,
-	.ai_flags = 0,
-	.ai_protocol = 0,
-	.ai_addrlen = 0,
-	.ai_addr = NULL,
-	.ai_canonname = NULL,
-	.ai_next = NULL
-};
-
 static struct {
-	pthread_mutex_t	start;
+	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
 	pthread_t		tid;
 	struct {
 		sigset_t	set;
 		u8			init;
 	}				sigs;
+	i32				wake;
+	u8				state;
+	u8				parked;
+	u8				spawned;
 }	kb_io_listener = {
-	.start = PTHREAD_MUTEX_INITIALIZER
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.wake = -1
 };
 
 static struct {
 	pthread_mutex_t	lock;
+	pthread_cond_t	cond;
+	pthread_t		tid;
+	net_rx			rx;
+	msg_srv_init	init;
+	u64				ttl;
+	u64				ready_at;
+	i32				socket;
+	i32				wake;
+	u8				version;
+	u8				enabled;
+	u8				connecting;
+	u8				busy;
+	u8				stop;
+}	prewarm = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.socket = -1,
+	.wake = -1
+};
+
+static struct {
 	game			state;
-}	_game = {
-	.lock = PTHREAD_MUTEX_INITIALIZER
+	jitter_buffer	playback;
+	struct {
+		f32			pos;
+		atomic u8	direction;
+		struct {
+			u64	at;
+			u8	direction;
+		}			inputs[_PREDICT_HISTORY];
+		u32			sent;
+	}				predicted[2];
+	u64				predicted_at;
+	u64				state_at;
+	bot				bots[2];
+	f32				paddle_speed;
+	atomic u8		paused;
+}	_game;
+
+static struct {
+	i32			epoll;
+	i32			signal;
+	i32			timer;
+	i32			command;
+	i32			replay;
+	i32			control;
+	atomic u64	replay_ops;
+	sigset_t	sigs;
+	u64			last_rx;
+	u64			timeout;
+	u64			frame_ns;
+	u64			ping_ns;
+	u64			next_ping;
+	u64			replay_start;
+	u64			replay_pos;
+	u8			replay_paused;
+	u8			streaming;
+	u8			redraw;
+	u8			masked;
+	u8			uring;
+	u8			peers;
+	u8			pending;
+	u8			holding;
+}	reactor = {
+	.epoll = -1,
+	.signal = -1,
+	.timer = -1,
+	.command = -1,
+	.replay = -1,
+	.control = -1
 };
 
+static net_addrs	server_addrs;
+static net_rx		state_rx;
+static net_udp		udp = {
+	.socket = -1
+};
+static net_clock	latency;
+static uring		ring;
+static cmd_queue	commands;
+static net_tx		tx[2];
+static command		held;
+static recorder		rec = {
+	.fd = -1
+};
+static replay		replay_src;
+
 static atomic u8	display_status;
 
+game_opts	game_options = {
+	.speed = 1.0f
+};
+
 struct {
-	const char	*addr;
-	const char	*port;
+	const char		*addr;
+	const char		*port;
 	struct {
 		i32	state;
 		i32	p1;
 		i32	p2;
-	}	sockets;
-	u8	version;
-	u8	running;
-	u8	direct;
+	}				sockets;
+	u8				version;
+	u8				running;
+	u8				direct;
+	msg_srv_init	init;
 }	server_info;
 
 static void	*_kb_io_listener(void *);
+static void	_kb_io_drain(void);
+static const kbinput_key	*_kb_io_next(const kbinput_listener_id binds);
+static u8	_kb_io_spawn(void);
+static void	_kb_io_set(const u8 state);
+static void	*_prewarm(void *);
+static void	_prewarm_stop(void);
 
 static inline const kbinput_key	*_p1_move_paddle(const kbinput_key *event);
 static inline const kbinput_key	*_p2_move_paddle(const kbinput_key *event);
@@ -109,59 +270,137 @@ static inline const kbinput_key	*_p2_toggle_pause(const kbinput_key *event);
 static inline const kbinput_key	*_p1_quit(const kbinput_key *event);
 static inline const kbinput_key	*_p2_quit(const kbinput_key *event);
 
-static inline u8	_move_paddle(const i32 socket, const direction direction);
-static inline u8	_toggle_pause(const i32 socket);
-static inline u8	_start(const i32 socket);
-static inline u8	_quit(const i32 socket);
+static inline u8	_move_paddle(const u8 player, const direction direction);
+static inline u8	_toggle_pause(const u8 player);
+static inline u8	_start(const u8 player);
+static inline u8	_quit(const u8 player);
+
+static inline const kbinput_key	*_replay_toggle(const kbinput_key *event);
+static inline const kbinput_key	*_replay_step(const kbinput_key *event);
+static inline const kbinput_key	*_replay_back(const kbinput_key *event);
+static inline const kbinput_key	*_replay_forward(const kbinput_key *event);
+static inline const kbinput_key	*_replay_quit(const kbinput_key *event);
+static inline u8				_replay_cmd(const u8 op);
+
+static inline const kbinput_key	*_rematch(const kbinput_key *event);
+static inline const kbinput_key	*_dismiss(const kbinput_key *event);
 
 static inline u8	_print_msg(const message_type msg, const u32 wait);
+static inline u8	_await_dismiss(const u32 wait);
+
+static inline void	_apply_msg(const message *msg);
+static inline void	_autopilot(const msg_srv_state *state);
+static inline u8	_render(void);
+static inline u8	_interpolate(game *frame, const u64 now);
+static inline u8	_predict(game *frame, const u64 now);
+static inline f32	_unreflected(const u8 player, const u64 from, const u64 now);
+
+static inline u8	_init_reactor(void);
+static inline void	_close_reactor(void);
+static inline u8	_watch(const i32 fd, const u32 events, const u32 id);
+static inline u8	_on_state(const u32 events);
+static inline u8	_on_uring(void);
+static inline u8	_on_recv(const void *data, const i32 n);
+static inline u8	_drain_state(void);
+static inline u8	_on_udp(void);
+static inline void	_on_pong(const msg_srv_pong *pong);
+static inline void	_ingest(const message *msg);
+static inline u8	_ping(void);
+static inline u8	_on_peer(const u8 player, const u32 events);
+static inline u8	_on_command(void);
+static inline u8	_drain_commands(void);
+static inline u8	_send_held(void);
+static inline u8	_flush(const u8 player);
+static inline u8	_on_replay(void);
+static inline u8	_arm_replay(void);
+static inline u8	_feed_replay(const u64 until);
+static inline u8	_on_control(void);
+static inline u8	_replay_control(const u8 op);
+static inline u64	_replay_clock(const u64 now);
+static inline u8	_on_signal(void);
+static inline u8	_on_tick(void);
 
 static inline void	_close(i32 fd);
 static inline u8	_init_connection(void);
-static inline u8	_connect(const char *addr, const char *port, i32 *sfd);
-static inline u8	_send(const i32 socket, const void *buf, const size_t n);
-static inline u8	_recv(const i32 socket, void *buf, const size_t n);
-static inline u8	_send_msg(const i32 socket, const message *msg);
-static inline u8	_recv_msg(const i32 socket, message *msg);
+static inline u8	_init_recording(void);
+static inline u8	_open_replay(msg_srv_init *init);
+static inline u64	_connect_timeout(void);
+static inline u8	_open_state(net_rx *rx, i32 *sfd, msg_srv_init *init, u8 *version, const u64 timeout);
+static inline const message	*_handshake(net_rx *rx, const i32 socket, const u64 deadline);
+static inline u8	_prewarm_take(msg_srv_init *init);
+static inline void	_prewarm_release(void);
+static inline u8	_send_msg(const u8 player, const message *msg);
 
 u8	setup_game_binds(void) {
 	u8	rv;
 
 	rv = 1;
+	// bot controlled paddles get no movement keys
 	switch (kb_protocol) {
 		case KB_INPUT_PROTOCOL_KITTY:
-			rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_UP, KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p2_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p2_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_UP, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+			if (!(game_options.bot & GAME_BOT_P1)) {
+				rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p1_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p1_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
+			}
+			if (!(game_options.bot & GAME_BOT_P2)) {
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_UP, KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p2_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_RELEASE, _p2_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_UP, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+			}
 			break ;
 		case KB_INPUT_PROTOCOL_LEGACY:
-			rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_LEGACY_UP, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
-			rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_LEGACY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+			if (!(game_options.bot & GAME_BOT_P1)) {
+				rv &= kbinput_add_listener(game_binds, kbinput_key('w', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key('s', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_move_paddle));
+			}
+			if (!(game_options.bot & GAME_BOT_P2)) {
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_LEGACY_UP, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+				rv &= kbinput_add_listener(game_binds, kbinput_key(KB_KEY_LEGACY_DOWN, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p2_move_paddle));
+			}
 	}
 	rv &= kbinput_add_listener(game_binds, kbinput_key('p', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_toggle_pause));
 	rv &= kbinput_add_listener(game_binds, kbinput_key('q', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _p1_quit));
 	rv &= kbinput_add_listener(game_binds, kbinput_key('p', KB_MOD_IGN_LCK | KB_MOD_SHIFT, KB_EVENT_PRESS, _p2_toggle_pause));
 	rv &= kbinput_add_listener(game_binds, kbinput_key('q', KB_MOD_IGN_LCK | KB_MOD_SHIFT, KB_EVENT_PRESS, _p2_quit));
+	rv &= kbinput_add_listener(replay_binds, kbinput_key(' ', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_toggle));
+	rv &= kbinput_add_listener(replay_binds, kbinput_key('p', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_toggle));
+	rv &= kbinput_add_listener(replay_binds, kbinput_key('.', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_step));
+	rv &= kbinput_add_listener(replay_binds, kbinput_key('q', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_quit));
+	switch (kb_protocol) {
+		case KB_INPUT_PROTOCOL_KITTY:
+			rv &= kbinput_add_listener(replay_binds, kbinput_key(KB_KEY_LEFT, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_back));
+			rv &= kbinput_add_listener(replay_binds, kbinput_key(KB_KEY_RIGHT, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_forward));
+			break ;
+		case KB_INPUT_PROTOCOL_LEGACY:
+			rv &= kbinput_add_listener(replay_binds, kbinput_key(KB_KEY_LEGACY_LEFT, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_back));
+			rv &= kbinput_add_listener(replay_binds, kbinput_key(KB_KEY_LEGACY_RIGHT, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _replay_forward));
+	}
+	rv &= kbinput_add_listener(over_binds, kbinput_key('r', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _rematch));
+	rv &= kbinput_add_listener(over_binds, kbinput_key('q', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _dismiss));
+	rv &= kbinput_add_listener(over_binds, kbinput_key(' ', KB_MOD_IGN_LCK, KB_EVENT_PRESS, _dismiss));
+	rv &= kbinput_add_listener(over_binds, kbinput_key(KB_KEY_ENTER, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _dismiss));
+	rv &= kbinput_add_listener(over_binds, kbinput_key(KB_KEY_ESCAPE, KB_MOD_IGN_LCK, KB_EVENT_PRESS, _dismiss));
 	return rv;
 }
 
 u8	play(void) {
-	message	msg;
-	u8		pause_state;
-	u8		rv;
+	struct epoll_event	events[_REACTOR_MAX_EVENTS];
+	i32					n;
+	i32					i;
+	u8					shown;
+	u8					rv;
 
-	if (!_init_connection()) {
+	if (!_init_connection() || !_init_recording() || !_init_reactor() || !_kb_io_spawn()) {
+		record_close(&rec);
+		replay_close(&replay_src);
+		_close_reactor();
 		_close(server_info.sockets.p1);
 		_close(server_info.sockets.p2);
 		_close(server_info.sockets.state);
-		pthread_mutex_unlock(&kb_io_listener.start);
+		_prewarm_release();
 		return 0;
 	}
 	server_info.running = 1;
@@ -172,126 +411,294 @@ u8	play(void) {
 	_game.state.p1_score = 0;
 	_game.state.p2_score = 0;
 	_game.state.started = 0;
-	_game.state.paused = 0x3U;
+	_game.paused = 0x3U;
 	_game.state.status = 0;
 	_game.state.actor = 0;
 	_game.state.over = 0;
+	_game.state.rtt = 0;
+	jitter_reset(&_game.playback);
+	_game.predicted[0].pos = _GAME_FIELD_Y / 2;
+	_game.predicted[1].pos = _GAME_FIELD_Y / 2;
+	_game.predicted[0].direction = STOP;
+	_game.predicted[1].direction = STOP;
+	_game.predicted[0].sent = 0;
+	_game.predicted[1].sent = 0;
+	_game.predicted_at = time_ns();
+	_game.state_at = _game.predicted_at;
+	bot_init(&_game.bots[0], 0);
+	bot_init(&_game.bots[1], 1);
 	display_status = display_game(&_game.state);
-	pthread_mutex_unlock(&kb_io_listener.start);
-	do {
-		errno = 0;
-		if (display_status == DISPLAY_GAME_WIN_TOO_SMALL) {
-			pthread_mutex_lock(&_game.lock);
-			display_status = display_game(&_game.state);
-			pause_state = _game.state.paused;
-			pthread_mutex_unlock(&_game.lock);
-			switch (display_status) {
-				case 0:
-					rv = 0;
+	_kb_io_set(_KB_IO_ACTIVE);
+	rv = 1;
+	while (rv && server_info.running && (!_game.state.over || game_options.replay)) {
+		n = epoll_wait(reactor.epoll, events, _REACTOR_MAX_EVENTS, -1);
+		if (n == -1) {
+			if (errno != EINTR)
+				rv = 0;
+			continue ;
+		}
+		for (i = 0; rv && server_info.running && (!_game.state.over || game_options.replay) && i < n; i++) {
+			switch (events[i].data.u32) {
+				case _EVENT_STATE:
+					rv = _on_state(events[i].events);
+					break ;
+				case _EVENT_P1:
+					rv = _on_peer(0, events[i].events);
+					break ;
+				case _EVENT_P2:
+					rv = _on_peer(1, events[i].events);
+					break ;
+				case _EVENT_SIGNAL:
+					rv = _on_signal();
+					break ;
+				case _EVENT_TIMER:
+					rv = _on_tick();
 					break ;
-				case DISPLAY_GAME_WIN_TOO_SMALL:
-					if (!(pause_state & 0x1))
-						_p1_toggle_pause((void *)0x1);
-					if (!(pause_state & 0x2))
-						_p2_toggle_pause((void *)0x1);
-					continue ;
+				case _EVENT_URING:
+					rv = _on_uring();
+					break ;
+				case _EVENT_COMMAND:
+					rv = _on_command();
+					break ;
+				case _EVENT_REPLAY:
+					rv = _on_replay();
+					break ;
+				case _EVENT_UDP:
+					rv = _on_udp();
+					break ;
+				case _EVENT_CONTROL:
+					rv = _on_control();
 			}
-			if (pause_state & 0x1)
-				_p1_toggle_pause((void *)0x1);
-			if (pause_state & 0x2)
-				_p2_toggle_pause((void *)0x1);
 		}
-		rv = _recv_msg(server_info.sockets.state, &msg);
-		if (!rv) {
-			if (errno == EINTR) {
-				rv = 1;
-				continue ;
-			} else if (!server_info.running)
-				rv = 1;
-			break ;
-		}
-		pthread_mutex_lock(&_game.lock);
-		switch (msg.type) {
-			case MESSAGE_SERVER_GAME_PAUSED:
-				break ;
-			case MESSAGE_SERVER_GAME_OVER:
-				_game.state.paused = 1;
-				_game.state.over = 1;
-				switch (server_info.version) {
-					case 0:
-						_game.state.status = GAME_OVER_ACT_WON;
-						_game.state.actor = msg.body.game_over.v0.winner_id;
-						break ;
-					case 1:
-						_game.state.p1_score = msg.body.game_over.v1.score >> 8 & 0xFF;
-						_game.state.p2_score = msg.body.game_over.v1.score & 0xFF;
-						_game.state.status = msg.body.game_over.v1.finish_status;
-						_game.state.actor = msg.body.game_over.v1.actor_id;
-				}
-				break ;
-			case MESSAGE_SERVER_STATE_UPDATE:
-				_game.state.paused = 0;
-				_game.state.started = 1;
-				_game.state.p1_pos = msg.body.state.p1_paddle;
-				_game.state.p2_pos = msg.body.state.p2_paddle;
-				_game.state.ball.x = msg.body.state.ball.x;
-				_game.state.ball.y = msg.body.state.ball.y;
-				_game.state.p1_score = msg.body.state.score >> 8 & 0xFF;
-				_game.state.p2_score = msg.body.state.score & 0xFF;
-		}
-		display_status = display_game(&_game.state);
-		pause_state = _game.state.paused;
-		pthread_mutex_unlock(&_game.lock);
-		switch (display_status) {
-			case 0:
-				rv = 0;
-				break ;
-			case DISPLAY_GAME_WIN_TOO_SMALL:
-				if (!(pause_state & 0x1))
-					_p1_toggle_pause((void *)0x1);
-				if (!(pause_state & 0x2))
-					_p2_toggle_pause((void *)0x1);
-		}
-		pthread_mutex_lock(&_game.lock);
-		if (_game.state.over)
-			break ;
-		pthread_mutex_unlock(&_game.lock);
-	} while (rv);
-	pthread_mutex_unlock(&_game.lock);
+	}
 	server_info.running = 0;
-	pthread_cancel(kb_io_listener.tid);
-	pthread_join(kb_io_listener.tid, NULL);
+	_kb_io_set(_KB_IO_IDLE);
+	_close_reactor();
+	record_close(&rec);
+	replay_close(&replay_src);
+	_close(server_info.sockets.state);
+	_close(server_info.sockets.p1);
+	_close(server_info.sockets.p2);
+	net_udp_close(&udp);
+	_prewarm_release();
 	rv = (write(1, "\x1b[=0u", 5) == 5) ? 1 : 0;
 	switch (_game.state.status) {
 		case GAME_OVER_ACT_WON:
-			_print_msg((_game.state.actor == 1) ? PLAYER1_WON : PLAYER2_WON, 5);
+			shown = _print_msg((_game.state.actor == 1) ? PLAYER1_WON : PLAYER2_WON, _GAME_OVER_WAIT);
 			break ;
 		case GAME_OVER_ACT_QUIT:
-			_print_msg((_game.state.actor == 1) ? PLAYER1_QUIT : PLAYER2_QUIT, 5);
+			shown = _print_msg((_game.state.actor == 1) ? PLAYER1_QUIT : PLAYER2_QUIT, _GAME_OVER_WAIT);
 			break ;
 		case GAME_OVER_SERVER_CLOSED:
-			_print_msg(SERVER_CLOSED, 5);
+			shown = _print_msg(SERVER_CLOSED, _GAME_OVER_WAIT);
+			break ;
+		default:
+			shown = 1;
 	}
-	_close(server_info.sockets.state);
-	_close(server_info.sockets.p1);
-	_close(server_info.sockets.p2);
-	return rv;
+	return (rv && shown == PLAY_REMATCH) ? PLAY_REMATCH : rv;
+}
+
+void	game_shutdown(void) {
+	_prewarm_stop();
+	if (!kb_io_listener.spawned)
+		return ;
+	_kb_io_set(_KB_IO_STOP);
+	pthread_join(kb_io_listener.tid, NULL);
+	_close(kb_io_listener.wake);
+	kb_io_listener.wake = -1;
+	kb_io_listener.spawned = 0;
+}
+
+u8	prewarm_start(void) {
+	const char	*tmp;
+	u64			n;
+
+	tmp = getenv("NETPONG_PREWARM");
+	if (!tmp || strcmp(tmp, "1") != 0 || prewarm.enabled || game_options.replay || game_options.bench)
+		return 1;
+	tmp = getenv("NETPONG_PREWARM_TTL");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 0;
+	prewarm.ttl = ((n && n <= UINT16_MAX) ? n : _PREWARM_TTL_DEFAULT) * 1000000000UL;
+	prewarm.wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (prewarm.wake == -1)
+		return 0;
+	prewarm.stop = 0;
+	prewarm.busy = 0;
+	if (pthread_create(&prewarm.tid, NULL, _prewarm, NULL) != 0) {
+		_close(prewarm.wake);
+		prewarm.wake = -1;
+		return 0;
+	}
+	prewarm.enabled = 1;
+	return 1;
+}
+
+static void	_prewarm_stop(void) {
+	const u64	wake = 1;
+
+	if (!prewarm.enabled)
+		return ;
+	pthread_mutex_lock(&prewarm.lock);
+	prewarm.stop = 1;
+	pthread_mutex_unlock(&prewarm.lock);
+	if (write(prewarm.wake, &wake, sizeof(wake)) == -1) { ; }
+	pthread_join(prewarm.tid, NULL);
+	_close(prewarm.wake);
+	prewarm.wake = -1;
+	prewarm.enabled = 0;
 }
 
 static void	*_kb_io_listener([[gnu::unused]] void *arg) {
-	const kbinput_key	*event;
+	struct pollfd	fds[2];
+	u64				n;
+	i32				flags;
 
 	pthread_sigmask(SIG_BLOCK, &_SIGS, NULL);
-	pthread_mutex_lock(&kb_io_listener.start);
-	pthread_mutex_unlock(&kb_io_listener.start);
-	while (1) {
-		event = kbinput_listen(game_binds);
-		if (event && display_status != DISPLAY_GAME_WIN_TOO_SMALL)
+	fds[0] = (struct pollfd){.fd = STDIN_FILENO, .events = POLLIN};
+	fds[1] = (struct pollfd){.fd = kb_io_listener.wake, .events = POLLIN};
+	flags = fcntl(STDIN_FILENO, F_GETFL);
+	pthread_mutex_lock(&kb_io_listener.lock);
+	while (kb_io_listener.state != _KB_IO_STOP) {
+		if (kb_io_listener.state == _KB_IO_IDLE) {
+			// the menu reads stdin blocking
+			if (flags != -1 && !kb_io_listener.parked)
+				fcntl(STDIN_FILENO, F_SETFL, flags);
+			kb_io_listener.parked = 1;
+			pthread_cond_broadcast(&kb_io_listener.cond);
+			pthread_cond_wait(&kb_io_listener.cond, &kb_io_listener.lock);
+			continue ;
+		}
+		if (flags != -1 && kb_io_listener.parked)
+			fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+		kb_io_listener.parked = 0;
+		pthread_mutex_unlock(&kb_io_listener.lock);
+		// poll cannot see what kbinput already buffered, so only wait once it is drained
+		_kb_io_drain();
+		if (poll(fds, 2, -1) > 0 && fds[1].revents & POLLIN && read(kb_io_listener.wake, &n, sizeof(n)) == -1) { ; }
+		pthread_mutex_lock(&kb_io_listener.lock);
+	}
+	if (flags != -1 && !kb_io_listener.parked)
+		fcntl(STDIN_FILENO, F_SETFL, flags);
+	kb_io_listener.parked = 1;
+	pthread_cond_broadcast(&kb_io_listener.cond);
+	pthread_mutex_unlock(&kb_io_listener.lock);
+	return NULL;
+}
+
+static void	_kb_io_drain(void) {
+	const kbinput_key	*event;
+
+	while ((event = _kb_io_next((game_options.replay) ? replay_binds : game_binds)))
+		if (display_status != DISPLAY_GAME_WIN_TOO_SMALL)
 			((game_fn)event->fn)(event);
+}
+
+// next event kbinput has buffered or can read without blocking, stdin must be non-blocking
+static const kbinput_key	*_kb_io_next(const kbinput_listener_id binds) {
+	const kbinput_key	*event;
+	u8					misses;
+
+	for (misses = 0; misses < _KB_IO_MAX_MISSES; misses++) {
+		errno = 0;
+		event = kbinput_listen(binds);
+		if (event)
+			return event;
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EBADF || errno == EIO)
+			return NULL;
 	}
 	return NULL;
 }
 
+static u8	_kb_io_spawn(void) {
+	if (kb_io_listener.spawned)
+		return 1;
+	kb_io_listener.wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (kb_io_listener.wake == -1)
+		return 0;
+	kb_io_listener.state = _KB_IO_IDLE;
+	if (pthread_create(&kb_io_listener.tid, NULL, _kb_io_listener, NULL) != 0) {
+		_close(kb_io_listener.wake);
+		kb_io_listener.wake = -1;
+		return 0;
+	}
+	kb_io_listener.spawned = 1;
+	return 1;
+}
+
+static void	_kb_io_set(const u8 state) {
+	const u64	wake = 1;
+
+	pthread_mutex_lock(&kb_io_listener.lock);
+	kb_io_listener.state = state;
+	pthread_cond_broadcast(&kb_io_listener.cond);
+	if (write(kb_io_listener.wake, &wake, sizeof(wake)) == -1) { ; }
+	while (state != _KB_IO_ACTIVE && !kb_io_listener.parked)
+		pthread_cond_wait(&kb_io_listener.cond, &kb_io_listener.lock);
+	pthread_mutex_unlock(&kb_io_listener.lock);
+}
+
+static void	*_prewarm([[gnu::unused]] void *arg) {
+	struct pollfd	fds[2];
+	sigset_t		sigs;
+	u64				backoff;
+	u64				expires;
+	u64				now;
+	i32				timeout;
+	i32				socket;
+	ssize_t			n;
+
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+	backoff = _PREWARM_BACKOFF_MIN;
+	pthread_mutex_lock(&prewarm.lock);
+	while (!prewarm.stop) {
+		timeout = -1;
+		if (!prewarm.busy && prewarm.socket == -1) {
+			prewarm.connecting = 1;
+			pthread_mutex_unlock(&prewarm.lock);
+			net_rx_reset(&prewarm.rx);
+			if (!_open_state(&prewarm.rx, &socket, &prewarm.init, &prewarm.version, _connect_timeout()))
+				socket = -1;
+			pthread_mutex_lock(&prewarm.lock);
+			prewarm.connecting = 0;
+			prewarm.socket = socket;
+			prewarm.ready_at = time_ns();
+			pthread_cond_broadcast(&prewarm.cond);
+			timeout = (socket == -1) ? (i32)backoff : -1;
+			if (socket != -1)
+				backoff = _PREWARM_BACKOFF_MIN;
+			else if (backoff < _PREWARM_BACKOFF_MAX)
+				backoff = (backoff * 2 < _PREWARM_BACKOFF_MAX) ? backoff * 2 : _PREWARM_BACKOFF_MAX;
+		}
+		socket = (prewarm.busy) ? -1 : prewarm.socket;
+		if (socket != -1) {
+			now = time_ns();
+			expires = prewarm.ready_at + prewarm.ttl;
+			timeout = (now < expires) ? (expires - now + 999999) / 1000000 : 0;
+		}
+		fds[0] = (struct pollfd){.fd = socket, .events = POLLIN};
+		fds[1] = (struct pollfd){.fd = prewarm.wake, .events = POLLIN};
+		pthread_mutex_unlock(&prewarm.lock);
+		n = poll(fds, 2, timeout);
+		pthread_mutex_lock(&prewarm.lock);
+		if (fds[1].revents & POLLIN && read(prewarm.wake, &now, sizeof(now)) == -1) { ; }
+		if (socket == -1 || socket != prewarm.socket || prewarm.busy || n == -1)
+			continue ;
+		if (!(fds[0].revents & (POLLHUP | POLLERR)) && fds[0].revents & POLLIN) {
+			n = net_rx_fill(&prewarm.rx, socket, MSG_DONTWAIT);
+			if (n > 0 || (n == -1 && errno == EAGAIN))
+				continue ;
+		} else if (!(fds[0].revents & (POLLHUP | POLLERR)) && time_ns() < prewarm.ready_at + prewarm.ttl)
+			continue ;
+		_close(socket);
+		prewarm.socket = -1;
+	}
+	_close(prewarm.socket);
+	prewarm.socket = -1;
+	pthread_mutex_unlock(&prewarm.lock);
+	return NULL;
+}
+
 static inline const kbinput_key	*_p1_move_paddle(const kbinput_key *event) {
 	static direction	direction = STOP;
 
@@ -315,7 +722,8 @@ static inline const kbinput_key	*_p1_move_paddle(const kbinput_key *event) {
 			else
 				direction = (direction != DOWN) ? DOWN : STOP;
 	}
-	return (_move_paddle(server_info.sockets.p1, direction)) ? event : NULL;
+	_game.predicted[0].direction = direction;
+	return (_move_paddle(0, direction)) ? event : NULL;
 }
 
 static inline const kbinput_key	*_p2_move_paddle(const kbinput_key *event) {
@@ -341,52 +749,49 @@ static inline const kbinput_key	*_p2_move_paddle(const kbinput_key *event) {
 			else
 				direction = (direction != DOWN) ? DOWN : STOP;
 	}
-	return (_move_paddle(server_info.sockets.p2, direction)) ? event : NULL;
+	_game.predicted[1].direction = direction;
+	return (_move_paddle(1, direction)) ? event : NULL;
 }
 
 static inline const kbinput_key	*_p1_toggle_pause(const kbinput_key *event) {
-	pthread_mutex_lock(&_game.lock);
-	switch (_game.state.paused & 0x1U) {
+	switch (atomic_fetch_xor(&_game.paused, 0x1U) & 0x1U) {
 		case 0x0U:
-			if (!_toggle_pause(server_info.sockets.p1))
+			if (!_toggle_pause(0))
 				event = NULL;
 			break ;
 		case 0x1U:
-			if (!_start(server_info.sockets.p1))
+			if (!_start(0))
 				event = NULL;
 	}
-	if (event != NULL)
-		_game.state.paused ^= 0x1U;
-	pthread_mutex_unlock(&_game.lock);
+	if (event == NULL)
+		atomic_fetch_xor(&_game.paused, 0x1U);
 	return event;
 }
 
 static inline const kbinput_key	*_p2_toggle_pause(const kbinput_key *event) {
-	pthread_mutex_lock(&_game.lock);
-	switch (_game.state.paused & 0x2U) {
+	switch (atomic_fetch_xor(&_game.paused, 0x2U) & 0x2U) {
 		case 0x0U:
-			if (!_toggle_pause(server_info.sockets.p2))
+			if (!_toggle_pause(1))
 				event = NULL;
 			break ;
 		case 0x2U:
-			if (!_start(server_info.sockets.p2))
+			if (!_start(1))
 				event = NULL;
 	}
-	if (event != NULL)
-		_game.state.paused ^= 0x2U;
-	pthread_mutex_unlock(&_game.lock);
+	if (event == NULL)
+		atomic_fetch_xor(&_game.paused, 0x2U);
 	return event;
 }
 
 static inline const kbinput_key	*_p1_quit(const kbinput_key *event) {
-	return (_quit(server_info.sockets.p1)) ? event : NULL;
+	return (_quit(0)) ? event : NULL;
 }
 
 static inline const kbinput_key	*_p2_quit(const kbinput_key *event) {
-	return (_quit(server_info.sockets.p2)) ? event : NULL;
+	return (_quit(1)) ? event : NULL;
 }
 
-static inline u8	_move_paddle(const i32 socket, const direction direction) {
+static inline u8	_move_paddle(const u8 player, const direction direction) {
 	message	msg;
 
 	msg = (message){
@@ -397,10 +802,10 @@ static inline u8	_move_paddle(const i32 socket, const direction direction) {
 	msg.body.move_paddle = (msg_clt_move_paddle){
 		.direction = direction
 	};
-	return _send_msg(socket, &msg);
+	return _send_msg(player, &msg);
 }
 
-static inline u8	_toggle_pause(const i32 socket) {
+static inline u8	_toggle_pause(const u8 player) {
 	message	msg;
 
 	msg = (message){
@@ -408,10 +813,10 @@ static inline u8	_toggle_pause(const i32 socket) {
 		.type = MESSAGE_CLIENT_PAUSE,
 		.length = 0
 	};
-	return _send_msg(socket, &msg);
+	return _send_msg(player, &msg);
 }
 
-static inline u8	_start(const i32 socket) {
+static inline u8	_start(const u8 player) {
 	message	msg;
 
 	msg = (message){
@@ -419,10 +824,10 @@ static inline u8	_start(const i32 socket) {
 		.type = MESSAGE_CLIENT_START,
 		.length = 0
 	};
-	return _send_msg(socket, &msg);
+	return _send_msg(player, &msg);
 }
 
-static inline u8	_quit(const i32 socket) {
+static inline u8	_quit(const u8 player) {
 	message	msg;
 
 	msg = (message){
@@ -430,68 +835,775 @@ static inline u8	_quit(const i32 socket) {
 		.type = MESSAGE_CLIENT_QUIT,
 		.length = 0
 	};
-	return _send_msg(socket, &msg);
+	return _send_msg(player, &msg);
+}
+
+static inline const kbinput_key	*_replay_toggle(const kbinput_key *event) {
+	return (_replay_cmd(_REPLAY_TOGGLE)) ? event : NULL;
+}
+
+static inline const kbinput_key	*_replay_step(const kbinput_key *event) {
+	return (_replay_cmd(_REPLAY_STEP)) ? event : NULL;
+}
+
+static inline const kbinput_key	*_replay_back(const kbinput_key *event) {
+	return (_replay_cmd(_REPLAY_BACK)) ? event : NULL;
+}
+
+static inline const kbinput_key	*_replay_forward(const kbinput_key *event) {
+	return (_replay_cmd(_REPLAY_FORWARD)) ? event : NULL;
+}
+
+static inline const kbinput_key	*_replay_quit(const kbinput_key *event) {
+	return (_replay_cmd(_REPLAY_QUIT)) ? event : NULL;
+}
+
+static inline u8	_replay_cmd(const u8 op) {
+	const u64	wake = 1;
+
+	atomic_fetch_add(&reactor.replay_ops, 1UL << (op * _REPLAY_OP_BITS));
+	return (write(reactor.control, &wake, sizeof(wake)) != -1 || errno == EAGAIN) ? 1 : 0;
+}
+
+static inline const kbinput_key	*_rematch(const kbinput_key *event) {
+	return event;
+}
+
+static inline const kbinput_key	*_dismiss(const kbinput_key *event) {
+	return event;
 }
 
 static inline u8	_print_msg(const message_type msg, const u32 wait) {
-	const char	*_msg[3];
+	const char	*_msg[4];
 
+	_msg[0] = _MSG_GAME_OVER;
 	switch (msg) {
 		case PLAYER1_WON:
-			_msg[0] = _MSG_GAME_OVER;
 			_msg[1] = _MSG_GAME_OVER_P1_WON;
-			_msg[2] = NULL;
 			break ;
 		case PLAYER2_WON:
-			_msg[0] = _MSG_GAME_OVER;
 			_msg[1] = _MSG_GAME_OVER_P2_WON;
-			_msg[2] = NULL;
 			break ;
 		case PLAYER1_QUIT:
-			_msg[0] = _MSG_GAME_OVER;
 			_msg[1] = _MSG_P1_QUIT;
-			_msg[2] = NULL;
 			break ;
 		case PLAYER2_QUIT:
-			_msg[0] = _MSG_GAME_OVER;
 			_msg[1] = _MSG_P2_QUIT;
-			_msg[2] = NULL;
 			break ;
 		case SERVER_CLOSED:
-			_msg[0] = _MSG_GAME_OVER;
 			_msg[1] = _MSG_SERVER_CLOSED;
-			_msg[2] = NULL;
 	}
+	_msg[2] = _MSG_DISMISS;
+	_msg[3] = NULL;
 	if (!display_msg(_msg))
 		return 0;
-	sleep(wait);
+	return (game_options.bench) ? 1 : _await_dismiss(wait);
+}
+
+static inline u8	_await_dismiss(const u32 wait) {
+	const kbinput_key	*event;
+	struct pollfd		pfd;
+	u64					deadline;
+	u64					now;
+	i32					flags;
+	u8					rv;
+
+	pfd = (struct pollfd){
+		.fd = STDIN_FILENO,
+		.events = POLLIN
+	};
+	flags = fcntl(STDIN_FILENO, F_GETFL);
+	if (flags != -1)
+		fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK);
+	deadline = time_ns() + wait * 1000000000UL;
+	for (rv = 1, event = NULL; (now = time_ns()) < deadline; ) {
+		// same as the listener, poll only sees what kbinput has not buffered yet
+		event = _kb_io_next(over_binds);
+		if (event)
+			break ;
+		if (poll(&pfd, 1, (deadline - now + 999999) / 1000000) == -1 && errno != EINTR)
+			break ;
+	}
+	if (event)
+		rv = ((game_fn)event->fn == _rematch) ? PLAY_REMATCH : 1;
+	if (flags != -1)
+		fcntl(STDIN_FILENO, F_SETFL, flags);
+	return rv;
+}
+
+static inline void	_apply_msg(const message *msg) {
+	switch (msg->type) {
+		case MESSAGE_SERVER_GAME_PAUSED:
+			break ;
+		case MESSAGE_SERVER_GAME_OVER:
+			_game.paused = 1;
+			_game.state.over = 1;
+			switch (server_info.version) {
+				case 0:
+					_game.state.status = GAME_OVER_ACT_WON;
+					_game.state.actor = msg->body.game_over.v0.winner_id;
+					break ;
+				default:
+					_game.state.p1_score = msg->body.game_over.v1.score >> 8 & 0xFF;
+					_game.state.p2_score = msg->body.game_over.v1.score & 0xFF;
+					_game.state.status = msg->body.game_over.v1.finish_status;
+					_game.state.actor = msg->body.game_over.v1.actor_id;
+			}
+			break ;
+		case MESSAGE_SERVER_STATE_UPDATE:
+			_game.paused = 0;
+			_game.state.started = 1;
+			_game.state.p1_pos = msg->body.state.p1_paddle;
+			_game.state.p2_pos = msg->body.state.p2_paddle;
+			_game.state.ball.x = msg->body.state.ball.x;
+			_game.state.ball.y = msg->body.state.ball.y;
+			_game.state.p1_score = msg->body.state.score >> 8 & 0xFF;
+			_game.state.p2_score = msg->body.state.score & 0xFF;
+			_game.state_at = time_ns();
+			jitter_push(&_game.playback, &_game.state, _game.state_at);
+			if (game_options.bot && !game_options.replay)
+				_autopilot(&msg->body.state);
+	}
+	reactor.streaming = (msg->type == MESSAGE_SERVER_STATE_UPDATE) ? 1 : 0;
+	reactor.last_rx = time_ns();
+	reactor.redraw = 1;
+}
+
+static inline void	_autopilot(const msg_srv_state *state) {
+	u8	i;
+
+	for (i = 0; i < 2; i++) {
+		if (!(game_options.bot & (1U << i)) || !bot_update(&_game.bots[i], state))
+			continue ;
+		_game.predicted[i].direction = _game.bots[i].direction;
+		_move_paddle(i, (direction)_game.bots[i].direction);
+	}
+}
+
+static inline u8	_render(void) {
+	game	frame;
+	u64		now;
+	u8		prev_status;
+	u8		pause_state;
+
+	prev_status = display_status;
+	pause_state = _game.paused;
+	now = time_ns();
+	frame = _game.state;
+	frame.paused = pause_state;
+	reactor.redraw = _interpolate(&frame, now);
+	reactor.redraw |= _predict(&frame, now);
+	display_status = display_game(&frame);
+	if (game_options.bench)
+		bench_frame(time_ns());
+	switch (display_status) {
+		case 0:
+			return 0;
+		case DISPLAY_GAME_WIN_TOO_SMALL:
+			if (!(pause_state & 0x1U))
+				_p1_toggle_pause((void *)0x1);
+			if (!(pause_state & 0x2U))
+				_p2_toggle_pause((void *)0x1);
+			break ;
+		default:
+			if (prev_status != DISPLAY_GAME_WIN_TOO_SMALL)
+				break ;
+			if (pause_state & 0x1U)
+				_p1_toggle_pause((void *)0x1);
+			if (pause_state & 0x2U)
+				_p2_toggle_pause((void *)0x1);
+	}
 	return 1;
 }
 
+static inline u8	_interpolate(game *frame, const u64 now) {
+	if (game_options.bench)
+		bench.playout = _game.playback.delay;
+	if (frame->over)
+		return 0;
+	return jitter_sample(&_game.playback, frame, now);
+}
+
+static inline u8	_predict(game *frame, const u64 now) {
+	u64	anchor;
+	u64	from;
+	f32	*pos;
+	f32	base;
+	f32	target;
+	f32	blend;
+	f32	dt;
+	u8	moving;
+	u8	i;
+
+	dt = (f32)(now - _game.predicted_at) / 1000000000.0f;
+	_game.predicted_at = now;
+	if (!_game.paddle_speed || frame->over)
+		return 0;
+	if (dt > _PREDICT_MAX_DT)
+		dt = _PREDICT_MAX_DT;
+	blend = 1.0f - expf(-dt / _PREDICT_TAU);
+	// reconcile against the state the ball is drawn from, which reflects the inputs
+	// sent up to one round trip before its place on the playout timeline. the local
+	// paddles then lead the ball by the playout delay at most, never more than
+	// NETPONG_JITTER_MAX
+	anchor = (_game.playback.count) ? _game.playback.playout : _game.state_at;
+	from = (latency.samples && anchor > latency.rtt) ? anchor - latency.rtt : anchor;
+	for (i = moving = 0; i < 2; i++) {
+		pos = &_game.predicted[i].pos;
+		base = (i == 0) ? frame->p1_pos : frame->p2_pos;
+		target = base;
+		if (frame->started && !frame->paused) {
+			target += _game.paddle_speed * _unreflected(i, from, now);
+			if (target < _PADDLE_HALF_HEIGHT)
+				target = _PADDLE_HALF_HEIGHT;
+			else if (target > _GAME_FIELD_Y - _PADDLE_HALF_HEIGHT)
+				target = _GAME_FIELD_Y - _PADDLE_HALF_HEIGHT;
+			switch (_game.predicted[i].direction) {
+				case UP:
+					*pos += _game.paddle_speed * dt;
+					moving = 1;
+					break ;
+				case DOWN:
+					*pos -= _game.paddle_speed * dt;
+					moving = 1;
+					break ;
+				case STOP:
+					break ;
+			}
+		}
+		*pos += (target - *pos) * blend;
+		if (*pos < _PADDLE_HALF_HEIGHT)
+			*pos = _PADDLE_HALF_HEIGHT;
+		else if (*pos > _GAME_FIELD_Y - _PADDLE_HALF_HEIGHT)
+			*pos = _GAME_FIELD_Y - _PADDLE_HALF_HEIGHT;
+		if (fabsf(target - *pos) > _PREDICT_EPSILON)
+			moving = 1;
+		if (game_options.bench)
+			bench_skew(fabsf(*pos - base));
+	}
+	frame->p1_pos = _game.predicted[0].pos;
+	frame->p2_pos = _game.predicted[1].pos;
+	return moving;
+}
+
+// signed seconds of movement from the inputs sent between from and now
+static inline f32	_unreflected(const u8 player, const u64 from, const u64 now) {
+	const u32	sent = _game.predicted[player].sent;
+	u64			start;
+	u64			end;
+	f32			travel;
+	u32			i;
+	u8			direction;
+
+	travel = 0.0f;
+	for (i = (sent > _PREDICT_HISTORY) ? sent - _PREDICT_HISTORY : 0; i < sent; i++) {
+		start = _game.predicted[player].inputs[i % _PREDICT_HISTORY].at;
+		end = (i + 1 < sent) ? _game.predicted[player].inputs[(i + 1) % _PREDICT_HISTORY].at : now;
+		if (start < from)
+			start = from;
+		if (end <= start)
+			continue ;
+		direction = _game.predicted[player].inputs[i % _PREDICT_HISTORY].direction;
+		travel += (f32)(end - start) / 1000000000.0f * ((direction == UP) - (direction == DOWN));
+	}
+	return travel;
+}
+
+static inline u8	_init_reactor(void) {
+	struct itimerspec	tick;
+	const char			*tmp;
+	u64					n;
+
+	reactor.epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (reactor.epoll == -1)
+		return 0;
+	if (sigemptyset(&reactor.sigs) == -1 || !add_sig(reactor.sigs, SIGWINCH))
+		return 0;
+	if (pthread_sigmask(SIG_BLOCK, &reactor.sigs, NULL) != 0)
+		return 0;
+	reactor.masked = 1;
+	reactor.signal = signalfd(-1, &reactor.sigs, SFD_NONBLOCK | SFD_CLOEXEC);
+	reactor.timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	reactor.command = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (reactor.signal == -1 || reactor.timer == -1 || reactor.command == -1)
+		return 0;
+	queue_init(&commands);
+	net_tx_reset(&tx[0]);
+	net_tx_reset(&tx[1]);
+	reactor.peers = 0x3U;
+	reactor.pending = 0;
+	reactor.holding = 0;
+	tmp = getenv("NETPONG_FPS");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : UINT64_MAX;
+	reactor.frame_ns = 1000000000UL / ((n && n <= _FPS_MAX) ? n : _FPS_DEFAULT);
+	tick = (struct itimerspec){
+		.it_interval = {.tv_sec = 0, .tv_nsec = reactor.frame_ns},
+		.it_value = {.tv_sec = 0, .tv_nsec = reactor.frame_ns}
+	};
+	if (timerfd_settime(reactor.timer, 0, &tick, NULL) == -1)
+		return 0;
+	reactor.redraw = 0;
+	tmp = getenv("NETPONG_PADDLE_SPEED");
+	_game.paddle_speed = (tmp) ? strtof(tmp, NULL) : _PADDLE_SPEED_DEFAULT;
+	if (!isfinite(_game.paddle_speed) || _game.paddle_speed < 0.0f)
+		_game.paddle_speed = _PADDLE_SPEED_DEFAULT;
+	tmp = getenv("NETPONG_SERVER_TIMEOUT");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : UINT64_MAX;
+	reactor.timeout = ((n <= UINT16_MAX) ? n : _SERVER_TIMEOUT_DEFAULT) * 1000000000UL;
+	reactor.last_rx = time_ns();
+	reactor.streaming = 0;
+	tmp = getenv("NETPONG_PING_INTERVAL");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : _PING_INTERVAL_DEFAULT;
+	reactor.ping_ns = ((n <= UINT16_MAX) ? n : _PING_INTERVAL_DEFAULT) * 1000000UL;
+	reactor.next_ping = reactor.last_rx;
+	tmp = getenv("NETPONG_JITTER_MAX");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : JITTER_MAX_DELAY_DEFAULT;
+	jitter_init(&_game.playback, ((n <= JITTER_MAX_DELAY_LIMIT) ? n : JITTER_MAX_DELAY_DEFAULT) * 1000000UL);
+	net_clock_reset(&latency);
+	if (game_options.replay) {
+		reactor.ping_ns = 0;
+		reactor.peers = 0;
+		reactor.timeout = UINT64_MAX;
+		reactor.replay = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		reactor.control = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		reactor.replay_ops = 0;
+		reactor.replay_start = time_ns();
+		reactor.replay_pos = 0;
+		reactor.replay_paused = 0;
+		if (reactor.replay == -1 || reactor.control == -1
+			|| !_watch(reactor.replay, EPOLLIN, _EVENT_REPLAY)
+			|| !_watch(reactor.control, EPOLLIN, _EVENT_CONTROL) || !_arm_replay())
+			return 0;
+	} else {
+		tmp = getenv("NETPONG_IO_BACKEND");
+		if (tmp && strcmp(tmp, "io_uring") == 0) {
+			reactor.uring = uring_init(&ring) && uring_recv(&ring, server_info.sockets.state);
+			if (!reactor.uring)
+				uring_close(&ring);
+		}
+		if (!((reactor.uring)
+				? _watch(ring.fd, EPOLLIN, _EVENT_URING)
+				: _watch(server_info.sockets.state, EPOLLIN | EPOLLRDHUP, _EVENT_STATE))
+			|| !_watch(server_info.sockets.p1, EPOLLRDHUP, _EVENT_P1)
+			|| !_watch(server_info.sockets.p2, EPOLLRDHUP, _EVENT_P2)
+			|| (udp.socket != -1 && !_watch(udp.socket, EPOLLIN, _EVENT_UDP)))
+			return 0;
+	}
+	return _watch(reactor.signal, EPOLLIN, _EVENT_SIGNAL)
+		&& _watch(reactor.timer, EPOLLIN, _EVENT_TIMER)
+		&& _watch(reactor.command, EPOLLIN, _EVENT_COMMAND);
+}
+
+static inline void	_close_reactor(void) {
+	_close(reactor.replay);
+	_close(reactor.control);
+	_close(reactor.command);
+	_close(reactor.timer);
+	_close(reactor.signal);
+	_close(reactor.epoll);
+	reactor.replay = -1;
+	reactor.control = -1;
+	reactor.command = -1;
+	reactor.timer = -1;
+	reactor.signal = -1;
+	reactor.epoll = -1;
+	if (reactor.uring) {
+		uring_close(&ring);
+		reactor.uring = 0;
+	}
+	if (reactor.masked) {
+		pthread_sigmask(SIG_UNBLOCK, &reactor.sigs, NULL);
+		reactor.masked = 0;
+	}
+}
+
+static inline u8	_watch(const i32 fd, const u32 events, const u32 id) {
+	struct epoll_event	event;
+
+	event = (struct epoll_event){
+		.events = events,
+		.data.u32 = id
+	};
+	return (epoll_ctl(reactor.epoll, EPOLL_CTL_ADD, fd, &event) != -1) ? 1 : 0;
+}
+
+static inline u8	_on_state(const u32 events) {
+	ssize_t	n;
+
+	n = (events & EPOLLIN) ? net_rx_fill(&state_rx, server_info.sockets.state, 0) : 0;
+	if (n == -1 && errno != EAGAIN && errno != EINTR)
+		return 0;
+	if (n == 0)
+		server_info.running = 0;
+	return _drain_state();
+}
+
+static inline u8	_on_uring(void) {
+	if (!uring_reap(&ring, _on_recv))
+		return 0;
+	if (!ring.unsupported && !ring.send.failed)
+		return _drain_commands();
+	// no multishot recv or a send failed, so both directions go back to epoll
+	if (epoll_ctl(reactor.epoll, EPOLL_CTL_DEL, ring.fd, NULL) == -1)
+		return 0;
+	uring_close(&ring);
+	reactor.uring = 0;
+	return _watch(server_info.sockets.state, EPOLLIN | EPOLLRDHUP, _EVENT_STATE) && _drain_commands();
+}
+
+static inline u8	_on_recv(const void *data, const i32 n) {
+	size_t	chunk;
+	size_t	room;
+	size_t	i;
+	u8		*buf;
+
+	if (n <= 0) {
+		if (n == 0)
+			server_info.running = 0;
+		return (n == 0) ? 1 : 0;
+	}
+	for (i = 0; i < (size_t)n; i += chunk) {
+		buf = net_rx_space(&state_rx, &room);
+		if (!room)
+			return 0;
+		chunk = ((size_t)n - i < room) ? (size_t)n - i : room;
+		memcpy(buf, (const u8 *)data + i, chunk);
+		net_rx_commit(&state_rx, chunk);
+		if (!_drain_state())
+			return 0;
+	}
+	return 1;
+}
+
+static inline u8	_drain_state(void) {
+	const message	*msg;
+	u8				urgent;
+
+	for (urgent = 0; !_game.state.over && (msg = net_rx_next(&state_rx, server_info.version)); ) {
+		if (msg->type == MESSAGE_SERVER_PONG) {
+			_on_pong(&msg->body.pong);
+			continue ;
+		}
+		_ingest(msg);
+		if (msg->type != MESSAGE_SERVER_STATE_UPDATE)
+			urgent = 1;
+	}
+	return (urgent) ? _render() : 1;
+}
+
+static inline u8	_on_udp(void) {
+	const message	*msg;
+
+	// tcp still carries the game, so datagram errors are never fatal
+	while (!_game.state.over && (msg = net_udp_next(&udp, server_info.version)))
+		_ingest(msg);
+	return 1;
+}
+
+static inline void	_on_pong(const msg_srv_pong *pong) {
+	if (!net_clock_sample(&latency, pong, wall_ns()))
+		return ;
+	_game.state.rtt = (latency.rtt / 1000 < UINT32_MAX) ? latency.rtt / 1000 : UINT32_MAX;
+	if (game_options.bench) {
+		bench.rtt = latency.rtt;
+		bench.offset = latency.offset;
+	}
+}
+
+static inline void	_ingest(const message *msg) {
+	record_push(&rec, msg);
+	_apply_msg(msg);
+	if (game_options.bench) {
+		bench.messages++;
+		if (!bench.rx_at)
+			bench.rx_at = reactor.last_rx;
+	}
+}
+
+static inline u8	_on_peer(const u8 player, const u32 events) {
+	if (events & _EVENT_HANGUP) {
+		reactor.peers &= ~(1U << player);
+		net_tx_reset(&tx[player]);
+		if (epoll_ctl(reactor.epoll, EPOLL_CTL_DEL, (player) ? server_info.sockets.p2 : server_info.sockets.p1, NULL) == -1)
+			return 0;
+		return _drain_commands();
+	}
+	if (!(events & EPOLLOUT))
+		return 1;
+	return _flush(player) && _drain_commands();
+}
+
+static inline u8	_on_command(void) {
+	u64	n;
+
+	if (read(reactor.command, &n, sizeof(n)) == -1 && errno != EAGAIN)
+		return 0;
+	return _drain_commands();
+}
+
+// a command that does not fit a backed up batch stays held, and the queue
+// stays put behind it, until EPOLLOUT makes room
+static inline u8	_drain_commands(void) {
+	if (!_send_held())
+		return 0;
+	while (!reactor.holding && queue_pop(&commands, &held)) {
+		if (held.msg.type == MESSAGE_CLIENT_MOVE_PADDLE) {
+			_game.predicted[held.player].inputs[_game.predicted[held.player].sent % _PREDICT_HISTORY].at = time_ns();
+			_game.predicted[held.player].inputs[_game.predicted[held.player].sent++ % _PREDICT_HISTORY].direction = held.msg.body.move_paddle.direction;
+		}
+		reactor.holding = 1;
+		if (!_send_held())
+			return 0;
+	}
+	return _flush(0) && _flush(1);
+}
+
+static inline u8	_send_held(void) {
+	if (!reactor.holding)
+		return 1;
+	if (!net_tx_push(&tx[held.player], &held.msg)) {
+		if (!_flush(held.player))
+			return 0;
+		if (!net_tx_push(&tx[held.player], &held.msg))
+			return 1;
+	}
+	reactor.holding = 0;
+	return 1;
+}
+
+static inline u8	_flush(const u8 player) {
+	struct epoll_event	event;
+	i32					socket;
+	u8					pending;
+	u8					i;
+
+	socket = (player) ? server_info.sockets.p2 : server_info.sockets.p1;
+	if (!(reactor.peers & 1U << player)) {
+		net_tx_reset(&tx[player]);
+		return 1;
+	}
+	if (reactor.uring) {
+		for (i = 0; i < tx[player].count; i++)
+			if (!uring_send(&ring, socket, &tx[player].msgs[i], MESSAGE_HEADER_SIZE + tx[player].msgs[i].length))
+				break ;
+		// whatever the ring had no room for is retried when its sends complete
+		net_tx_consume(&tx[player], i);
+		return uring_submit(&ring);
+	}
+	pending = 0;
+	switch (net_tx_flush(&tx[player], socket)) {
+		case -1:
+			net_tx_reset(&tx[player]);
+			break ;
+		case 0:
+			pending = 1;
+	}
+	if (pending == ((reactor.pending >> player) & 0x1U))
+		return 1;
+	reactor.pending ^= 1U << player;
+	event = (struct epoll_event){
+		.events = EPOLLRDHUP | ((pending) ? EPOLLOUT : 0),
+		.data.u32 = _EVENT_P1 + player
+	};
+	return (epoll_ctl(reactor.epoll, EPOLL_CTL_MOD, socket, &event) != -1) ? 1 : 0;
+}
+
+static inline u8	_on_replay(void) {
+	u64	expirations;
+
+	if (read(reactor.replay, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+		return 0;
+	if (reactor.replay_paused)
+		return 1;
+	return _feed_replay(_replay_clock(time_ns())) && _arm_replay();
+}
+
+static inline u8	_arm_replay(void) {
+	struct itimerspec	when;
+	u64					at;
+
+	when = (struct itimerspec){0};
+	if (!replay_peek(&replay_src, &at)) {
+		// hold the last frame so it can still be scrubbed back, only q ends a replay
+		if (!reactor.replay_paused) {
+			reactor.replay_pos = _replay_clock(time_ns());
+			reactor.replay_start = time_ns();
+			reactor.replay_paused = 1;
+		}
+	} else if (!reactor.replay_paused) {
+		at = (at > reactor.replay_pos) ? (u64)((at - reactor.replay_pos) / game_options.speed) : 0;
+		at += reactor.replay_start;
+		when.it_value = (struct timespec){.tv_sec = at / 1000000000UL, .tv_nsec = at % 1000000000UL};
+		if (!when.it_value.tv_sec && !when.it_value.tv_nsec)
+			when.it_value.tv_nsec = 1;
+	}
+	return (timerfd_settime(reactor.replay, TFD_TIMER_ABSTIME, &when, NULL) != -1) ? 1 : 0;
+}
+
+static inline u8	_feed_replay(const u64 until) {
+	const message	*msg;
+	u64				at;
+	size_t			room;
+	size_t			size;
+	u8				*buf;
+
+	while ((msg = replay_peek(&replay_src, &at)) && at <= until) {
+		size = MESSAGE_HEADER_SIZE + msg->length;
+		buf = net_rx_space(&state_rx, &room);
+		if (room < size) {
+			if (!_drain_state())
+				return 0;
+			buf = net_rx_space(&state_rx, &room);
+			if (room < size)
+				break ;
+		}
+		memcpy(buf, msg, size);
+		net_rx_commit(&state_rx, size);
+		replay_skip(&replay_src);
+	}
+	return _drain_state();
+}
+
+static inline u8	_on_control(void) {
+	u64	ops;
+	u64	n;
+	u8	op;
+
+	if (read(reactor.control, &n, sizeof(n)) == -1 && errno != EAGAIN)
+		return 0;
+	ops = atomic_exchange(&reactor.replay_ops, 0);
+	for (op = 0; op < _REPLAY_OPS; op++)
+		for (n = (ops >> (op * _REPLAY_OP_BITS)) & _REPLAY_OP_MASK; n; n--)
+			if (!_replay_control(op))
+				return 0;
+	return 1;
+}
+
+static inline u8	_replay_control(const u8 op) {
+	u64	now;
+	u64	pos;
+	u64	at;
+
+	now = time_ns();
+	pos = _replay_clock(now);
+	switch (op) {
+		case _REPLAY_TOGGLE:
+			reactor.replay_paused ^= 1;
+			break ;
+		case _REPLAY_STEP:
+			reactor.replay_paused = 1;
+			if (replay_peek(&replay_src, &at) && at > pos)
+				pos = at;
+			break ;
+		case _REPLAY_BACK:
+		case _REPLAY_FORWARD:
+			if (op == _REPLAY_BACK)
+				pos = (pos > _REPLAY_JUMP_NS) ? pos - _REPLAY_JUMP_NS : 0;
+			else
+				pos += _REPLAY_JUMP_NS;
+			replay_seek(&replay_src, pos);
+			net_rx_reset(&state_rx);
+			_game.state.over = 0;
+			_game.state.status = 0;
+			jitter_reset(&_game.playback);
+			break ;
+		case _REPLAY_QUIT:
+			server_info.running = 0;
+			return 1;
+		default:
+			return 1;
+	}
+	reactor.replay_pos = pos;
+	reactor.replay_start = now;
+	return _feed_replay(pos) && _arm_replay() && _render();
+}
+
+static inline u64	_replay_clock(const u64 now) {
+	if (reactor.replay_paused)
+		return reactor.replay_pos;
+	return reactor.replay_pos + (u64)((now - reactor.replay_start) * game_options.speed);
+}
+
+static inline u8	_on_signal(void) {
+	struct signalfd_siginfo	info;
+
+	while (read(reactor.signal, &info, sizeof(info)) == sizeof(info))
+		;
+	if (errno != EAGAIN)
+		return 0;
+	update_display_size();
+	return _render();
+}
+
+static inline u8	_on_tick(void) {
+	u64	expirations;
+
+	if (read(reactor.timer, &expirations, sizeof(expirations)) == -1 && errno != EAGAIN)
+		return 0;
+	if (reactor.ping_ns && server_info.version >= NET_PING_VERSION && (reactor.peers & 0x1U)
+		&& time_ns() >= reactor.next_ping && !_ping())
+		return 0;
+	if (display_status == DISPLAY_GAME_WIN_TOO_SMALL)
+		return _render();
+	if (reactor.streaming && !_game.paused && time_ns() - reactor.last_rx > reactor.timeout) {
+		_game.state.over = 1;
+		_game.state.status = GAME_OVER_SERVER_CLOSED;
+	}
+	if (_game.predicted[0].direction != STOP || _game.predicted[1].direction != STOP)
+		reactor.redraw = 1;
+	return (reactor.redraw) ? _render() : 1;
+}
+
+static inline u8	_ping(void) {
+	message	msg;
+
+	reactor.next_ping = time_ns() + reactor.ping_ns;
+	msg = (message){
+		.version = server_info.version,
+		.type = MESSAGE_CLIENT_PING,
+		.length = sizeof(msg_clt_ping)
+	};
+	msg.body.ping.sent = wall_ns();
+	return _send_msg(0, &msg);
+}
+
 static inline void	_close(i32 fd) {
 	if (fd >= 0)
 		close(fd);
 }
 
 static inline u8	_init_connection(void) {
-	message	msg;
-	char	port[6];
+	msg_srv_init	init;
+	u64				timeout;
+	u16				ports[2];
+	i32				sockets[2];
+	u8				n;
 
 	server_info.sockets.p1 = -1;
 	server_info.sockets.p2 = -1;
 	server_info.sockets.state = -1;
-	pthread_mutex_lock(&kb_io_listener.start);
-	if (!_connect(server_info.addr, server_info.port, &server_info.sockets.state))
-		return 0;
-	if (!_recv_msg(server_info.sockets.state, &msg) || msg.type != MESSAGE_SERVER_GAME_INIT)
-		return 0;
-	server_info.version = msg.version;
-	utoa16(msg.body.init.p1_port, port);
-	if (!_connect(server_info.addr, port, &server_info.sockets.p1))
-		return 0;
-	utoa16(msg.body.init.p2_port, port);
-	if (!_connect(server_info.addr, port, &server_info.sockets.p2))
-		return 0;
+	if (game_options.replay) {
+		if (!_open_replay(&init))
+			return 0;
+	} else {
+		timeout = _connect_timeout();
+		if (!_prewarm_take(&init)) {
+			net_rx_reset(&state_rx);
+			if (!_open_state(&state_rx, &server_info.sockets.state, &init, &server_info.version, timeout))
+				return 0;
+		}
+		ports[0] = init.p1_port;
+		ports[1] = init.p2_port;
+		if (!net_connect(&server_addrs, ports, sockets, 2, timeout))
+			return 0;
+		server_info.sockets.p1 = sockets[0];
+		server_info.sockets.p2 = sockets[1];
+		// without an answer the server keeps streaming over tcp, so failures here are not fatal
+		if (game_options.udp && net_udp_open(&udp, server_info.sockets.state, init.udp_port, init.udp_token))
+			for (n = 0; n < NET_UDP_HELLO_COUNT; n++)
+				net_udp_hello(&udp);
+	}
+	server_info.init = init;
 	if (!kb_io_listener.sigs.init) {
 		if (sigemptyset(&_SIGS) == -1)
 			return 0;
@@ -506,71 +1618,146 @@ static inline u8	_init_connection(void) {
 			return 0;
 		kb_io_listener.sigs.init = 1;
 	}
-	return (pthread_create(&kb_io_listener.tid, NULL, _kb_io_listener, NULL) == 0) ? 1 : 0;
+	return 1;
 }
 
-static inline u8	_connect(const char *addr, const char *port, i32 *sfd) {
-	struct addrinfo	*addresses;
-	struct addrinfo	*cur_address;
+static inline u8	_init_recording(void) {
+	static u32	games = 0;
+	message		msg;
+	char		path[PATH_MAX];
 
-	if (getaddrinfo(addr, port, &hints, &addresses) != 0)
+	if (!game_options.record)
+		return 1;
+	// later games of the session go to FILE.2, FILE.3, ... instead of truncating FILE
+	if (games++ && snprintf(path, sizeof(path), "%s.%u", game_options.record, games) >= (i32)sizeof(path))
 		return 0;
-	for (cur_address = addresses; cur_address; cur_address = cur_address->ai_next) {
-		*sfd = socket(cur_address->ai_family, cur_address->ai_socktype, cur_address->ai_protocol);
-		if (*sfd) {
-			if (connect(*sfd, cur_address->ai_addr, cur_address->ai_addrlen) != -1)
-				break ;
-			close(*sfd);
-		}
-	}
-	freeaddrinfo(addresses);
-	return (cur_address != NULL) ? 1 : 0;
+	if (!record_open(&rec, (games > 1) ? path : game_options.record))
+		return 0;
+	msg = (message){
+		.version = server_info.version,
+		.type = MESSAGE_SERVER_GAME_INIT,
+		.length = MESSAGE_SERVER_INIT_SIZE
+	};
+	msg.body.init = server_info.init;
+	record_push(&rec, &msg);
+	return 1;
 }
 
-static inline u8	_send(const i32 socket, const void *buf, const size_t n) {
-	ssize_t	bytes_sent;
-	size_t	total_sent;
+static inline u8	_open_replay(msg_srv_init *init) {
+	const message	*msg;
+	u64				at;
 
-	total_sent = 0;
-	do {
-		bytes_sent = send(socket, (const void *)((uintptr_t)buf + total_sent), n - total_sent, 0);
-		total_sent += bytes_sent;
-	} while (bytes_sent != -1 && total_sent < n);
-	return (bytes_sent != -1) ? 1 : 0;
+	net_rx_reset(&state_rx);
+	if (!replay_open(&replay_src, game_options.replay))
+		return 0;
+	msg = replay_peek(&replay_src, &at);
+	if (!msg || msg->type != MESSAGE_SERVER_GAME_INIT)
+		return 0;
+	// states are recorded after v2 expansion, so they always use the v1 layout
+	server_info.version = (msg->version < 2) ? msg->version : 1;
+	net_init_body(msg, init);
+	replay_skip(&replay_src);
+	return 1;
 }
 
-static inline u8	_recv(const i32 socket, void *buf, const size_t n) {
-	ssize_t	bytes_read;
-	size_t	total_read;
+static inline u64	_connect_timeout(void) {
+	const char	*tmp;
+	u64			n;
 
-	total_read = 0;
-	do {
-		bytes_read = recv(socket, (void *)((uintptr_t)buf + total_read), n - total_read, MSG_WAITALL);
-		total_read += bytes_read;
-	} while (bytes_read > 0 && total_read < n);
-	if (bytes_read == 0 && server_info.running)
-		server_info.running = 0;
-	return (bytes_read != -1 && total_read > 0) ? 1 : 0;
+	tmp = getenv("NETPONG_CONNECT_TIMEOUT");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 0;
+	return ((n && n <= UINT16_MAX) ? n : _CONNECT_TIMEOUT_DEFAULT) * 1000000000UL;
 }
 
-static inline u8	_send_msg(const i32 socket, const message *msg) {
-	return _send(socket, msg, MESSAGE_HEADER_SIZE + msg->length);
-}
+static inline u8	_open_state(net_rx *rx, i32 *sfd, msg_srv_init *init, u8 *version, const u64 timeout) {
+	const message	*msg;
+	u16				port;
 
-static inline u8	_recv_msg(const i32 socket, message *msg) {
-	if (!_recv(socket, msg, MESSAGE_HEADER_SIZE))
+	port = net_port(server_info.port);
+	if (!port || !net_resolve(&server_addrs, server_info.addr))
+		return 0;
+	if (!net_connect(&server_addrs, &port, sfd, 1, timeout)) {
+		server_addrs.count = 0;
 		return 0;
-	switch (msg->type) {
-		case MESSAGE_SERVER_GAME_INIT:
-			return _recv(socket, &msg->body.init, sizeof(msg->body.init));
-		case MESSAGE_SERVER_GAME_PAUSED:
-			return 1;
-		case MESSAGE_SERVER_GAME_OVER:
-			if (server_info.version == 0)
-				return _recv(socket, &msg->body.game_over.v0, sizeof(msg->body.game_over.v0));
-			return _recv(socket, &msg->body.game_over.v1, sizeof(msg->body.game_over.v1));
-		case MESSAGE_SERVER_STATE_UPDATE:
-			return _recv(socket, &msg->body.state, sizeof(msg->body.state));
 	}
+	msg = _handshake(rx, *sfd, time_ns() + timeout);
+	if (!msg || msg->type != MESSAGE_SERVER_GAME_INIT) {
+		close(*sfd);
+		*sfd = -1;
+		return 0;
+	}
+	*version = (msg->version < NET_PROTOCOL_VERSION) ? msg->version : NET_PROTOCOL_VERSION;
+	net_init_body(msg, init);
 	return 1;
 }
+
+static inline const message	*_handshake(net_rx *rx, const i32 socket, const u64 deadline) {
+	const message	*msg;
+	struct pollfd	pfd;
+	ssize_t			n;
+	u64				now;
+
+	pfd = (struct pollfd){
+		.fd = socket,
+		.events = POLLIN
+	};
+	while (!(msg = net_rx_next(rx, 0))) {
+		now = time_ns();
+		if (now >= deadline)
+			return NULL;
+		if (poll(&pfd, 1, (deadline - now + 999999) / 1000000) == -1 && errno != EINTR)
+			return NULL;
+		n = net_rx_fill(rx, socket, 0);
+		if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR))
+			return NULL;
+	}
+	return msg;
+}
+
+static inline u8	_prewarm_take(msg_srv_init *init) {
+	const u64	wake = 1;
+	u8			rv;
+
+	if (!prewarm.enabled)
+		return 0;
+	pthread_mutex_lock(&prewarm.lock);
+	prewarm.busy = 1;
+	while (prewarm.connecting)
+		pthread_cond_wait(&prewarm.cond, &prewarm.lock);
+	rv = (prewarm.socket != -1 && time_ns() < prewarm.ready_at + prewarm.ttl) ? 1 : 0;
+	if (rv) {
+		server_info.sockets.state = prewarm.socket;
+		server_info.version = prewarm.version;
+		state_rx = prewarm.rx;
+		*init = prewarm.init;
+	} else
+		_close(prewarm.socket);
+	prewarm.socket = -1;
+	pthread_mutex_unlock(&prewarm.lock);
+	if (write(prewarm.wake, &wake, sizeof(wake)) == -1) { ; }
+	return rv;
+}
+
+static inline void	_prewarm_release(void) {
+	const u64	wake = 1;
+
+	if (!prewarm.enabled)
+		return ;
+	pthread_mutex_lock(&prewarm.lock);
+	prewarm.busy = 0;
+	pthread_mutex_unlock(&prewarm.lock);
+	if (write(prewarm.wake, &wake, sizeof(wake)) == -1) { ; }
+}
+
+static inline u8	_send_msg(const u8 player, const message *msg) {
+	const u64	wake = 1;
+	command		cmd;
+
+	cmd = (command){
+		.player = player,
+		.msg = *msg
+	};
+	if (!queue_push(&commands, &cmd))
+		return 0;
+	return (write(reactor.command, &wake, sizeof(wake)) != -1 || errno == EAGAIN) ? 1 : 0;
+}
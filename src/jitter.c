@@ -0,0 +1,115 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<jitter.c>>
+
+#include "jitter.h"
+
+// gains of the running estimates, as shifts
+#define _INTERVAL_GAIN	4
+#define _JITTER_GAIN	4
+#define _TIMELINE_GAIN	3
+#define _SHRINK_GAIN	6
+
+// target delay in mean deviations of the inter-arrival time
+#define _JITTER_SPREAD	3
+
+// a longer silence is a pause or a stall, not jitter
+#define _JITTER_GAP_NS	250000000UL
+
+#define _SLOT(buf, i)	(&(buf)->slots[((buf)->head + JITTER_SLOTS - (buf)->count + (i)) % JITTER_SLOTS])
+
+static inline i64	_toward(const i64 value, const i64 target, const u8 gain);
+static inline f32	_lerp(const f32 from, const f32 to, const f32 t);
+
+void	jitter_init(jitter_buffer *buf, const u64 max_delay) {
+	*buf = (jitter_buffer){
+		.max_delay = max_delay
+	};
+}
+
+void	jitter_reset(jitter_buffer *buf) {
+	buf->count = 0;
+	buf->playout = 0;
+}
+
+void	jitter_push(jitter_buffer *buf, const game *state, const u64 now) {
+	const u64	prev_at = (buf->count) ? _SLOT(buf, buf->count - 1)->at : 0;
+	const u64	prev_arrival = (buf->count) ? _SLOT(buf, buf->count - 1)->arrival : 0;
+	u64			target;
+	u64			gap;
+	u64			at;
+
+	gap = now - prev_arrival;
+	if (buf->count && gap > _JITTER_GAP_NS)
+		jitter_reset(buf);
+	at = now;
+	if (buf->count) {
+		if (!buf->interval)
+			buf->interval = gap;
+		buf->jitter = _toward(buf->jitter, (gap > buf->interval) ? gap - buf->interval : buf->interval - gap, _JITTER_GAIN);
+		buf->interval = _toward(buf->interval, gap, _INTERVAL_GAIN);
+		// play on an evenly spaced timeline that only drifts slowly toward the arrivals
+		at = _toward(prev_at + buf->interval, now, _TIMELINE_GAIN);
+		if (!buf->max_delay || at <= prev_at || (now > at && now - at > buf->max_delay))
+			at = (now > prev_at && now - prev_at > buf->max_delay) ? now : prev_at + 1;
+	}
+	buf->slots[buf->head].state = *state;
+	buf->slots[buf->head].arrival = now;
+	buf->slots[buf->head].at = at;
+	buf->head = (buf->head + 1) % JITTER_SLOTS;
+	if (buf->count < JITTER_SLOTS)
+		buf->count++;
+	// grow at once on a bad link, give latency back slowly once it is clean
+	target = buf->interval + _JITTER_SPREAD * buf->jitter;
+	if (target > buf->max_delay)
+		target = buf->max_delay;
+	buf->delay = (target > buf->delay) ? target : (u64)_toward(buf->delay, target, _SHRINK_GAIN);
+}
+
+u8	jitter_sample(jitter_buffer *buf, game *frame, const u64 now) {
+	const game	*from;
+	const game	*to;
+	u64			span;
+	u32			i;
+	f32			t;
+
+	if (!buf->count)
+		return 0;
+	// a growing delay pauses playback instead of rewinding it
+	if (now - buf->delay > buf->playout)
+		buf->playout = now - buf->delay;
+	for (i = buf->count - 1; i > 0 && _SLOT(buf, i)->at > buf->playout; i--)
+		;
+	from = &_SLOT(buf, i)->state;
+	frame->p1_pos = from->p1_pos;
+	frame->p2_pos = from->p2_pos;
+	frame->ball.x = from->ball.x;
+	frame->ball.y = from->ball.y;
+	frame->p1_score = from->p1_score;
+	frame->p2_score = from->p2_score;
+	if (i == buf->count - 1)
+		return 0;
+	to = &_SLOT(buf, i + 1)->state;
+	span = _SLOT(buf, i + 1)->at - _SLOT(buf, i)->at;
+	if (buf->playout < _SLOT(buf, i)->at || from->p1_score != to->p1_score || from->p2_score != to->p2_score)
+		return 1;
+	t = (f32)(buf->playout - _SLOT(buf, i)->at) / span;
+	frame->p1_pos = _lerp(from->p1_pos, to->p1_pos, t);
+	frame->p2_pos = _lerp(from->p2_pos, to->p2_pos, t);
+	frame->ball.x = _lerp(from->ball.x, to->ball.x, t);
+	frame->ball.y = _lerp(from->ball.y, to->ball.y, t);
+	return 1;
+}
+
+static inline i64	_toward(const i64 value, const i64 target, const u8 gain) {
+	return value + (target - value) / (1 << gain);
+}
+
+static inline f32	_lerp(const f32 from, const f32 to, const f32 t) {
+	return from + (to - from) * t;
+}
@@ -0,0 +1,539 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<loadgen.c>>
+
+#include <errno.h>
+#include <stdio.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+
+#include "bot.h"
+#include "net.h"
+#include "utils.h"
+#include "loadgen.h"
+
+#define _CONNECT_TIMEOUT_DEFAULT	5
+
+#define _EVENTS_MAX	256
+
+#define _EVENT_STOP		UINT64_MAX
+#define _EVENT_TIMER	(UINT64_MAX - 1)
+
+#define _SOCKET_STATE	0
+#define _SOCKET_P1		1
+#define _SOCKET_P2		2
+
+#define _event(session, socket)	((u64)(session) << 2 | (socket))
+
+typedef enum {
+	_STAGE_STATE,
+	_STAGE_INIT,
+	_STAGE_PLAYERS,
+	_STAGE_PLAYING,
+	_STAGE_DONE,
+	_STAGE_FAILED
+}	_stage;
+
+typedef struct {
+	net_rx		rx;
+	net_clock	clock;
+	bot			bots[2];
+	i32		sockets[3];
+	u64		started;
+	u64		connected;
+	u64		first_at;
+	u64		last_at;
+	u64		messages;
+	u64		inputs;
+	u64		lost;
+	u8		addr;
+	u8		stage;
+	u8		pending;
+	u8		version;
+	u8		status;
+	u8		actor;
+}	_session;
+
+typedef struct {
+	pthread_t	tid;
+	_session	*sessions;
+	u64			ticks;
+	u32			count;
+	u32			live;
+	i32			epoll;
+	i32			timer;
+}	_worker;
+
+static u8	_limit_fds(const u32 sessions);
+static u8	_wait(const i32 sfd, const u32 workers);
+static void	*_work(void *arg);
+static void	_report(const _worker *workers, const u32 count, const u32 sessions, const u64 elapsed);
+static void	_report_spread(const char *label, u64 *values, const u32 count);
+static i32	_cmp_u64(const void *a, const void *b);
+
+static inline void	_start(_worker *w, const u32 i);
+static inline u8	_dial(_worker *w, const u32 i);
+static inline void	_on_event(_worker *w, const u32 i, const u8 socket, const u32 events);
+static inline void	_on_state(_worker *w, _session *s);
+static inline u8	_on_msg(_worker *w, _session *s, const message *msg);
+static inline u8	_connected(const i32 socket);
+static inline void	_steer(_session *s, const msg_srv_state *state);
+static inline void	_tick(_worker *w);
+static inline void	_finish(_worker *w, _session *s, const _stage stage);
+
+static struct {
+	net_addrs	addrs;
+	u64			timeout;
+	u16			port;
+	i32			stop;
+	i32			done;
+}	loadgen = {.stop = -1, .done = -1};
+
+u8	loadgen_run(const char *addr, const char *port, const u32 sessions) {
+	_worker		*workers;
+	sigset_t	sigs;
+	const char	*tmp;
+	u64			start;
+	u64			n;
+	u32			count;
+	u32			i;
+	i32			sfd;
+	u8			rv;
+
+	loadgen.port = net_port(port);
+	tmp = getenv("NETPONG_CONNECT_TIMEOUT");
+	n = (tmp) ? strtoul(tmp, NULL, 10) : 0;
+	loadgen.timeout = ((n && n <= UINT16_MAX) ? n : _CONNECT_TIMEOUT_DEFAULT) * 1000000000UL;
+	if (!loadgen.port || !sessions || sessions > LOADGEN_SESSIONS_MAX || !net_resolve(&loadgen.addrs, addr)) {
+		fprintf(stderr, "%s: unable to resolve %s:%s\n", PROG_NAME, addr, port);
+		return 0;
+	}
+	if (!_limit_fds(sessions))
+		fprintf(stderr, "%s: open file limit is too low for %u sessions\n", PROG_NAME, sessions);
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	count = (n > 0 && n < sessions) ? n : sessions;
+	workers = calloc(count, sizeof(*workers));
+	sigemptyset(&sigs);
+	sigaddset(&sigs, SIGINT);
+	sigaddset(&sigs, SIGTERM);
+	sigaddset(&sigs, SIGPIPE);
+	loadgen.stop = eventfd(0, EFD_CLOEXEC);
+	loadgen.done = eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE);
+	sfd = -1;
+	if (!workers || loadgen.stop == -1 || loadgen.done == -1 || pthread_sigmask(SIG_BLOCK, &sigs, NULL) != 0
+		|| (sfd = signalfd(-1, &sigs, SFD_CLOEXEC)) == -1) {
+		rv = 0;
+		count = 0;
+		goto out;
+	}
+	start = time_ns();
+	for (i = 0; i < count; i++) {
+		workers[i].count = sessions / count + (i < sessions % count);
+		workers[i].sessions = calloc(workers[i].count, sizeof(*workers[i].sessions));
+		if (!workers[i].sessions || pthread_create(&workers[i].tid, NULL, _work, &workers[i]) != 0) {
+			free(workers[i].sessions);
+			break ;
+		}
+	}
+	rv = (i == count) ? 1 : 0;
+	if (rv)
+		rv = _wait(sfd, count);
+	else
+		count = i;
+	if (!rv)
+		eventfd_write(loadgen.stop, 1);
+	for (i = 0; i < count; i++)
+		pthread_join(workers[i].tid, NULL);
+	if (count)
+		_report(workers, count, sessions, time_ns() - start);
+out:
+	for (i = 0; i < count; i++)
+		free(workers[i].sessions);
+	free(workers);
+	if (sfd != -1)
+		close(sfd);
+	if (loadgen.stop != -1)
+		close(loadgen.stop);
+	if (loadgen.done != -1)
+		close(loadgen.done);
+	return rv;
+}
+
+static u8	_limit_fds(const u32 sessions) {
+	struct rlimit	limit;
+	u64				need;
+
+	need = 3 * (u64)sessions + 64;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == -1)
+		return 0;
+	if (limit.rlim_cur >= need)
+		return 1;
+	limit.rlim_cur = (limit.rlim_max < need) ? limit.rlim_max : need;
+	return (setrlimit(RLIMIT_NOFILE, &limit) != -1 && limit.rlim_cur >= need) ? 1 : 0;
+}
+
+static u8	_wait(const i32 sfd, const u32 workers) {
+	struct signalfd_siginfo	info;
+	struct epoll_event		events[2];
+	eventfd_t				n;
+	u32						done;
+	i32						epfd;
+	i32						i;
+
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if (epfd == -1)
+		return 0;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, sfd, &(struct epoll_event){.events = EPOLLIN, .data.fd = sfd});
+	epoll_ctl(epfd, EPOLL_CTL_ADD, loadgen.done, &(struct epoll_event){.events = EPOLLIN, .data.fd = loadgen.done});
+	for (done = 0; done < workers; ) {
+		i = epoll_wait(epfd, events, 2, -1);
+		if (i == -1 && errno != EINTR)
+			break ;
+		while (i-- > 0) {
+			if (events[i].data.fd == loadgen.done && eventfd_read(loadgen.done, &n) == 0)
+				done++;
+			else if (events[i].data.fd == sfd && read(sfd, &info, sizeof(info)) == sizeof(info) && info.ssi_signo != SIGPIPE)
+				goto out;
+		}
+	}
+out:
+	close(epfd);
+	return (done == workers) ? 1 : 0;
+}
+
+static void	*_work(void *arg) {
+	struct epoll_event	events[_EVENTS_MAX];
+	struct itimerspec	tick;
+	_worker				*w;
+	u32					i;
+	i32					n;
+
+	w = arg;
+	w->epoll = epoll_create1(EPOLL_CLOEXEC);
+	w->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	tick = (struct itimerspec){
+		.it_interval.tv_nsec = 1000000000L / LOADGEN_TICK_HZ,
+		.it_value.tv_nsec = 1000000000L / LOADGEN_TICK_HZ
+	};
+	if (w->epoll == -1 || w->timer == -1 || timerfd_settime(w->timer, 0, &tick, NULL) == -1
+		|| epoll_ctl(w->epoll, EPOLL_CTL_ADD, w->timer, &(struct epoll_event){.events = EPOLLIN, .data.u64 = _EVENT_TIMER}) == -1
+		|| epoll_ctl(w->epoll, EPOLL_CTL_ADD, loadgen.stop, &(struct epoll_event){.events = EPOLLIN, .data.u64 = _EVENT_STOP}) == -1)
+		w->count = 0;
+	for (i = 0, w->live = w->count; i < w->count; i++)
+		_start(w, i);
+	while (w->live) {
+		n = epoll_wait(w->epoll, events, _EVENTS_MAX, -1);
+		if (n == -1 && errno != EINTR)
+			break ;
+		while (n-- > 0) {
+			if (events[n].data.u64 == _EVENT_STOP)
+				goto out;
+			if (events[n].data.u64 == _EVENT_TIMER)
+				_tick(w);
+			else
+				_on_event(w, events[n].data.u64 >> 2, events[n].data.u64 & 0x3, events[n].events);
+		}
+	}
+out:
+	for (i = 0; i < w->count; i++)
+		if (w->sessions[i].stage < _STAGE_DONE)
+			_finish(w, &w->sessions[i], _STAGE_FAILED);
+	if (w->timer != -1)
+		close(w->timer);
+	if (w->epoll != -1)
+		close(w->epoll);
+	eventfd_write(loadgen.done, 1);
+	return NULL;
+}
+
+static void	_report(const _worker *workers, const u32 count, const u32 sessions, const u64 elapsed) {
+	const _session	*s;
+	u64				*connects;
+	u64				*rtts;
+	u64				messages;
+	u64				inputs;
+	u64				lost;
+	u32				statuses[4];
+	u32				pinged;
+	u32				connected;
+	u32				failed;
+	f64				rate;
+	f64				rate_min;
+	f64				rate_max;
+	f64				rate_sum;
+	u32				rated;
+	u32				i;
+	u32				j;
+
+	connects = malloc(sessions * sizeof(*connects));
+	rtts = malloc(sessions * sizeof(*rtts));
+	memset(statuses, 0, sizeof(statuses));
+	messages = inputs = lost = 0;
+	connected = failed = rated = pinged = 0;
+	rate_min = rate_max = rate_sum = 0.0;
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < workers[i].count; j++) {
+			s = &workers[i].sessions[j];
+			messages += s->messages;
+			inputs += s->inputs;
+			lost += s->lost;
+			statuses[(s->status < 4) ? s->status : 0]++;
+			if (s->stage == _STAGE_FAILED && !s->status)
+				failed++;
+			if (s->connected && connects)
+				connects[connected] = s->connected;
+			connected += (s->connected != 0);
+			if (s->clock.samples && rtts)
+				rtts[pinged++] = s->clock.rtt;
+			if (s->messages < 2 || s->last_at == s->first_at)
+				continue ;
+			rate = (f64)(s->messages - 1) * 1e9 / (f64)(s->last_at - s->first_at);
+			rate_min = (!rated || rate < rate_min) ? rate : rate_min;
+			rate_max = (rate > rate_max) ? rate : rate_max;
+			rate_sum += rate;
+			rated++;
+		}
+	}
+	fprintf(stdout, "loadgen: %u sessions on %u workers, %.2fs\n", sessions, count, (f64)elapsed / 1e9);
+	fprintf(stdout, "  sessions    connected %u, failed %u\n", connected, failed);
+	if (connects)
+		_report_spread("connect", connects, connected);
+	if (rtts)
+		_report_spread("rtt", rtts, pinged);
+	fprintf(stdout, "  messages    %lu total, %.0f/s\n", messages, (f64)messages * 1e9 / (f64)elapsed);
+	if (rated)
+		fprintf(stdout, "  per session min %.1f/s, avg %.1f/s, max %.1f/s\n", rate_min, rate_sum / rated, rate_max);
+	fprintf(stdout, "  inputs      %lu sent, %lu lost\n", inputs - lost, lost);
+	fprintf(stdout, "  game over   won %u, quit %u, server closed %u, none %u\n",
+		statuses[GAME_OVER_ACT_WON], statuses[GAME_OVER_ACT_QUIT], statuses[GAME_OVER_SERVER_CLOSED], statuses[0]);
+	free(connects);
+	free(rtts);
+}
+
+static void	_report_spread(const char *label, u64 *values, const u32 count) {
+	if (!count)
+		return ;
+	qsort(values, count, sizeof(*values), _cmp_u64);
+	fprintf(stdout, "  %-11s p50 %.3fms, p99 %.3fms, max %.3fms\n", label, (f64)values[count / 2] / 1e6,
+		(f64)values[(u64)count * 99 / 100] / 1e6, (f64)values[count - 1] / 1e6);
+}
+
+static i32	_cmp_u64(const void *a, const void *b) {
+	return (*(const u64 *)a > *(const u64 *)b) - (*(const u64 *)a < *(const u64 *)b);
+}
+
+static inline void	_start(_worker *w, const u32 i) {
+	_session	*s;
+
+	s = &w->sessions[i];
+	s->sockets[_SOCKET_P1] = -1;
+	s->sockets[_SOCKET_P2] = -1;
+	net_clock_reset(&s->clock);
+	bot_init(&s->bots[0], 0);
+	bot_init(&s->bots[1], 1);
+	s->started = time_ns();
+	s->stage = _STAGE_STATE;
+	s->addr = 0;
+	net_rx_reset(&s->rx);
+	if (!_dial(w, i))
+		_finish(w, s, _STAGE_FAILED);
+}
+
+// tries the resolved addresses in order from s->addr, the players then follow whichever one answered
+static inline u8	_dial(_worker *w, const u32 i) {
+	_session	*s;
+
+	s = &w->sessions[i];
+	for (; s->addr < loadgen.addrs.count; s->addr++) {
+		s->sockets[_SOCKET_STATE] = net_connect_start(&loadgen.addrs, s->addr, loadgen.port);
+		if (s->sockets[_SOCKET_STATE] == -1)
+			continue ;
+		if (epoll_ctl(w->epoll, EPOLL_CTL_ADD, s->sockets[_SOCKET_STATE],
+				&(struct epoll_event){.events = EPOLLOUT, .data.u64 = _event(i, _SOCKET_STATE)}) != -1)
+			return 1;
+		close(s->sockets[_SOCKET_STATE]);
+		s->sockets[_SOCKET_STATE] = -1;
+	}
+	return 0;
+}
+
+static inline void	_on_event(_worker *w, const u32 i, const u8 socket, const u32 events) {
+	_session	*s;
+
+	s = &w->sessions[i];
+	if (s->stage >= _STAGE_DONE)
+		return ;
+	if (socket != _SOCKET_STATE) {
+		epoll_ctl(w->epoll, EPOLL_CTL_DEL, s->sockets[socket], NULL);
+		if (!_connected(s->sockets[socket]))
+			_finish(w, s, _STAGE_FAILED);
+		else if (--s->pending == 0) {
+			s->stage = _STAGE_PLAYING;
+			s->connected = time_ns() - s->started;
+		}
+		return ;
+	}
+	if (s->stage == _STAGE_STATE) {
+		if (!_connected(s->sockets[_SOCKET_STATE])) {
+			close(s->sockets[_SOCKET_STATE]);
+			s->sockets[_SOCKET_STATE] = -1;
+			s->addr++;
+			if (!_dial(w, i))
+				_finish(w, s, _STAGE_FAILED);
+		} else if (epoll_ctl(w->epoll, EPOLL_CTL_MOD, s->sockets[_SOCKET_STATE],
+				&(struct epoll_event){.events = EPOLLIN, .data.u64 = _event(i, _SOCKET_STATE)}) == -1)
+			_finish(w, s, _STAGE_FAILED);
+		else
+			s->stage = _STAGE_INIT;
+		return ;
+	}
+	if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+		_on_state(w, s);
+}
+
+static inline void	_on_state(_worker *w, _session *s) {
+	const message	*msg;
+	ssize_t			n;
+
+	while ((n = net_rx_fill(&s->rx, s->sockets[_SOCKET_STATE], MSG_DONTWAIT)) > 0 || (n == -1 && errno == ENOBUFS)) {
+		while (s->stage < _STAGE_DONE && (msg = net_rx_next(&s->rx, s->version)))
+			if (!_on_msg(w, s, msg))
+				return ;
+		if (s->stage >= _STAGE_DONE)
+			return ;
+	}
+	if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+		s->status = (s->stage == _STAGE_PLAYING) ? GAME_OVER_SERVER_CLOSED : 0;
+		_finish(w, s, (s->stage == _STAGE_PLAYING) ? _STAGE_DONE : _STAGE_FAILED);
+	}
+}
+
+static inline u8	_on_msg(_worker *w, _session *s, const message *msg) {
+	const u32	i = s - w->sessions;
+	u64			now;
+	u8			j;
+
+	switch (msg->type) {
+		case MESSAGE_SERVER_GAME_INIT:
+			if (s->stage != _STAGE_INIT)
+				break ;
+			s->version = (msg->version < NET_PROTOCOL_VERSION) ? msg->version : NET_PROTOCOL_VERSION;
+			s->stage = _STAGE_PLAYERS;
+			s->pending = 2;
+			s->sockets[_SOCKET_P1] = net_connect_start(&loadgen.addrs, s->addr, msg->body.init.p1_port);
+			s->sockets[_SOCKET_P2] = net_connect_start(&loadgen.addrs, s->addr, msg->body.init.p2_port);
+			for (j = _SOCKET_P1; j <= _SOCKET_P2; j++) {
+				if (s->sockets[j] == -1 || epoll_ctl(w->epoll, EPOLL_CTL_ADD, s->sockets[j],
+						&(struct epoll_event){.events = EPOLLOUT, .data.u64 = _event(i, j)}) == -1) {
+					_finish(w, s, _STAGE_FAILED);
+					return 0;
+				}
+			}
+			break ;
+		case MESSAGE_SERVER_STATE_UPDATE:
+			now = time_ns();
+			if (!s->messages)
+				s->first_at = now;
+			s->last_at = now;
+			s->messages++;
+			if (s->stage == _STAGE_PLAYING)
+				_steer(s, &msg->body.state);
+			break ;
+		case MESSAGE_SERVER_GAME_OVER:
+			switch (s->version) {
+				case 0:
+					s->status = GAME_OVER_ACT_WON;
+					s->actor = msg->body.game_over.v0.winner_id;
+					break ;
+				default:
+					s->status = msg->body.game_over.v1.finish_status;
+					s->actor = msg->body.game_over.v1.actor_id;
+			}
+			_finish(w, s, _STAGE_DONE);
+			return 0;
+		case MESSAGE_SERVER_PONG:
+			net_clock_sample(&s->clock, &msg->body.pong, wall_ns());
+	}
+	return 1;
+}
+
+static inline u8	_connected(const i32 socket) {
+	socklen_t	len;
+	i32			err;
+
+	len = sizeof(err);
+	return (getsockopt(socket, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) ? 1 : 0;
+}
+
+static inline void	_steer(_session *s, const msg_srv_state *state) {
+	message	msg;
+	u8		i;
+
+	msg = (message){
+		.version = s->version,
+		.type = MESSAGE_CLIENT_MOVE_PADDLE,
+		.length = sizeof(msg_clt_move_paddle)
+	};
+	for (i = 0; i < 2; i++) {
+		if (!bot_update(&s->bots[i], state))
+			continue ;
+		msg.body.move_paddle.direction = s->bots[i].direction;
+		s->inputs++;
+		// a full socket buffer drops the input, like a congested link would
+		if (send(s->sockets[_SOCKET_P1 + i], &msg, MESSAGE_HEADER_SIZE + msg.length, MSG_DONTWAIT | MSG_NOSIGNAL)
+			!= MESSAGE_HEADER_SIZE + msg.length)
+			s->lost++;
+	}
+}
+
+static inline void	_tick(_worker *w) {
+	_session	*s;
+	message		msg;
+	u64			expired;
+	u64			now;
+	u32			i;
+	u8			ping;
+
+	if (read(w->timer, &expired, sizeof(expired)) == -1) { ; }
+	now = time_ns();
+	ping = (++w->ticks % LOADGEN_TICK_HZ == 0) ? 1 : 0;
+	for (i = 0; i < w->count; i++) {
+		s = &w->sessions[i];
+		if (s->stage < _STAGE_PLAYING && now - s->started > loadgen.timeout)
+			_finish(w, s, _STAGE_FAILED);
+		if (!ping || s->stage != _STAGE_PLAYING || s->version < NET_PING_VERSION)
+			continue ;
+		msg = (message){
+			.version = s->version,
+			.type = MESSAGE_CLIENT_PING,
+			.length = sizeof(msg_clt_ping)
+		};
+		msg.body.ping.sent = wall_ns();
+		if (send(s->sockets[_SOCKET_P1], &msg, MESSAGE_HEADER_SIZE + msg.length, MSG_DONTWAIT | MSG_NOSIGNAL) == -1) { ; }
+	}
+}
+
+static inline void	_finish(_worker *w, _session *s, const _stage stage) {
+	u8	i;
+
+	for (i = 0; i < 3; i++) {
+		if (s->sockets[i] != -1)
+			close(s->sockets[i]);
+		s->sockets[i] = -1;
+	}
+	s->stage = stage;
+	w->live--;
+}
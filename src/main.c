@@ -9,20 +9,69 @@
 
 #include <stdio.h>
 #include <signal.h>
+#include <stdlib.h>
+#include <string.h>
 #include <kbinput/kbinput.h>
 
 #include "menu.h"
+#include "game.h"
+#include "loadgen.h"
 
 #define handle_sig(sig)	((sigaction(sig, &action, NULL) != -1) ? 1 : 0)
 
 static inline void	_fatal_sig(i32 sig);
+static inline i32	_usage(void);
 
 static struct sigaction	action;
 
 int	main(i32 ac, char **av) {
-	if (ac < 3) {
-		fprintf(stdout, "Usage: %s address port\n", PROG_NAME);
-		return 1;
+	const char	*args[2];
+	u64			loadgen;
+	i32			n;
+	i32			i;
+
+	for (i = 1, n = 0, loadgen = 0; i < ac; i++) {
+		if (strcmp(av[i], "--record") == 0 && i + 1 < ac)
+			game_options.record = av[++i];
+		else if (strcmp(av[i], "--replay") == 0 && i + 1 < ac)
+			game_options.replay = av[++i];
+		else if (strcmp(av[i], "--speed") == 0 && i + 1 < ac)
+			game_options.speed = strtof(av[++i], NULL);
+		else if (strcmp(av[i], "--bench") == 0)
+			game_options.bench = 1;
+		else if (strcmp(av[i], "--udp") == 0)
+			game_options.udp = 1;
+		else if (strcmp(av[i], "--bot") == 0 && i + 1 < ac) {
+			i++;
+			if (strcmp(av[i], "p1") == 0)
+				game_options.bot = GAME_BOT_P1;
+			else if (strcmp(av[i], "p2") == 0)
+				game_options.bot = GAME_BOT_P2;
+			else if (strcmp(av[i], "both") == 0)
+				game_options.bot = GAME_BOT_P1 | GAME_BOT_P2;
+			else
+				return _usage();
+		}
+		else if (strcmp(av[i], "--loadgen") == 0 && i + 1 < ac) {
+			loadgen = strtoul(av[++i], NULL, 10);
+			if (!loadgen || loadgen > LOADGEN_SESSIONS_MAX)
+				return _usage();
+		}
+		else if (av[i][0] == '-' || n == 2)
+			return _usage();
+		else
+			args[n++] = av[i];
+	}
+	if (n != ((game_options.replay || game_options.bench) ? 0 : 2) || (game_options.replay && game_options.bench)
+		|| !(game_options.speed > 0.0f && game_options.speed <= 1000.0f))
+		return _usage();
+	if (loadgen && (game_options.replay || game_options.bench || game_options.record))
+		return _usage();
+	if (loadgen)
+		return loadgen_run(args[0], args[1], loadgen) ? 0 : 1;
+	if (game_options.replay || game_options.bench) {
+		args[0] = NULL;
+		args[1] = NULL;
 	}
 	action.sa_handler = _fatal_sig;
 	if (!handle_sig(SIGABRT) || !handle_sig(SIGALRM) || !handle_sig(SIGBUS) ||
@@ -34,7 +83,7 @@ int	main(i32 ac, char **av) {
 		!handle_sig(SIGUSR2) || !handle_sig(SIGVTALRM) ||
 		!handle_sig(SIGXCPU) || !handle_sig(SIGXFSZ))
 		return 1;
-	return main_menu(av[1], av[2]) ? 0 : 1;
+	return main_menu(args[0], args[1]) ? 0 : 1;
 }
 
 static inline void	_fatal_sig(i32 sig) {
@@ -43,3 +92,11 @@ static inline void	_fatal_sig(i32 sig) {
 	sigaction(sig, &action, NULL);
 	raise(sig);
 }
+
+static inline i32	_usage(void) {
+	fprintf(stdout, "Usage: %s address port [--record FILE] [--bot p1|p2|both] [--udp]\n", PROG_NAME);
+	fprintf(stdout, "       %s --replay FILE [--speed N]\n", PROG_NAME);
+	fprintf(stdout, "       %s --bench [--record FILE] [--bot p1|p2|both] [--udp]\n", PROG_NAME);
+	fprintf(stdout, "       %s address port --loadgen N\n", PROG_NAME);
+	return 1;
+}
@@ -16,12 +16,11 @@
 
 #include "menu.h"
 #include "game.h"
+#include "bench.h"
 #include "display.h"
 
 #define CSI	"\x1b["
 
-#define _COLOR_CODE_COUNT	256
-
 #define _SMCUP	CSI "?1049h"
 #define _RMCUP	CSI "?1049l"
 
@@ -55,6 +54,8 @@ extern struct {
 
 kbinput_listener_id	menu_binds;
 kbinput_listener_id	game_binds;
+kbinput_listener_id	over_binds;
+kbinput_listener_id	replay_binds;
 u8					kb_protocol;
 
 struct {
@@ -96,7 +97,7 @@ static inline menu_item	*_new_item(const char *title, const menu *prev, const me
 static inline u8		_add_right(menu_item *ref, menu_item *new);
 static inline u8		_add_below(menu_item *ref, menu_item *new);
 
-static const char	*color_codes[_COLOR_CODE_COUNT] = {
+const char	*color_codes[MENU_COLOR_COUNT] = {
 	"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10", "11", "12", "13", "14", "15",
 	"16", "17", "18", "19", "20", "21", "22", "23", "24", "25", "26", "27", "28", "29", "30",
 	"31", "32", "33", "34", "35", "36", "37", "38", "39", "40", "41", "42", "43", "44", "45",
@@ -125,6 +126,20 @@ u8	main_menu(const char *server_addr, const char *server_port) {
 		return 0;
 	rv = 1;
 	kbinput_set_cursor_mode(OFF);
+	if (game_options.replay) {
+		rv = play() != 0;
+		game_shutdown();
+		cleanup();
+		return rv;
+	}
+	if (game_options.bench) {
+		rv = bench_run();
+		game_shutdown();
+		cleanup();
+		if (rv)
+			bench_report();
+		return rv;
+	}
 	while (rv) {
 		display_menu(menus.current);
 		event = kbinput_listen(menu_binds);
@@ -143,6 +158,7 @@ u8	main_menu(const char *server_addr, const char *server_port) {
 			rv = 0;
 		}
 	}
+	game_shutdown();
 	cleanup();
 	return rv;
 }
@@ -196,9 +212,13 @@ static inline const kbinput_key	*_navigate(const kbinput_key *event) {
 }
 
 static inline const kbinput_key	*_select(const kbinput_key *event) {
+	u8	rv;
+
 	switch (menus.current->current->action) {
 		case PLAY:
-			return (play()) ? event : NULL;
+			while ((rv = play()) == PLAY_REMATCH)
+				;
+			return (rv) ? event : NULL;
 		case LOGIN:
 			break ;
 		case ENTER_MENU:
@@ -262,16 +282,17 @@ static inline u8	_init(const char *server_addr, const char *server_port) {
 	kb_protocol = kbinput_get_input_protocol();
 	menu_binds = kbinput_new_listener();
 	game_binds = kbinput_new_listener();
-	if (menu_binds == -1 || game_binds == -1)
+	over_binds = kbinput_new_listener();
+	replay_binds = kbinput_new_listener();
+	if (menu_binds == -1 || game_binds == -1 || over_binds == -1 || replay_binds == -1)
 		return 0;
 	if (!_setup_menu_binds() || !setup_game_binds())
 		return 0;
-	setvbuf(stdout, NULL, _IOFBF, 4096);
 	if (!_setup_menus())
 		return 0;
 	server_info.addr = server_addr;
 	server_info.port = server_port;
-	return init_display();
+	return prewarm_start() && init_display();
 }
 
 static inline u8	_setup_menu_binds(void) {
@@ -485,7 +506,7 @@ static inline u8	_setup_colormenu(menu *_menu, const menu *prev, opt_setter sett
 	menu_item	*tmp;
 	size_t		i;
 
-	for (i = 1, tmp = down = _menu->root; i < _COLOR_CODE_COUNT; i++) {
+	for (i = 1, tmp = down = _menu->root; i < MENU_COLOR_COUNT; i++) {
 		if (i && i % 8) {
 			if (!_add_right(tmp, _new_item(color_codes[i], prev, NULL, SELECT_OPTION, setter, i)))
 				return 0;
@@ -0,0 +1,533 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<mock.c>>
+
+#include <math.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#include "mock.h"
+#include "utils.h"
+
+#define _FIELD_X	40.0f
+#define _FIELD_Y	20.0f
+
+#define _PADDLE_HALF_HEIGHT	1.5f
+#define _PADDLE_SPEED		GAME_PADDLE_SPEED
+#define _BALL_SPEED_X		18.0f
+#define _BALL_SPEED_Y		11.0f
+
+#define _SOCKET_STATE	0
+#define _SOCKET_P1		1
+#define _SOCKET_P2		2
+
+#define _MOVE_UP	0x1U
+#define _MOVE_DOWN	0x2U
+
+static inline u8	_accept(mock_server *srv, const u8 i);
+static inline u8	_send(const i32 socket, const message *msg);
+static inline void	_drain(mock_server *srv);
+static inline void	_drain_udp(mock_server *srv);
+static inline u8	_parse(mock_server *srv, const u8 player, const u8 *buf, size_t len);
+static inline u8	_handle(mock_server *srv, const u8 player, const message *msg);
+static inline void	_step(mock_server *srv, const f32 dt);
+static inline void	_serve(mock_server *srv, const f32 direction);
+static inline u8	_send_state(mock_server *srv);
+static inline u8	_send_datagram(mock_server *srv, message *msg);
+static inline void	_encode_v2(mock_server *srv, message *msg);
+static inline i16	_quantize(const f32 n);
+static inline u8	_send_paused(mock_server *srv);
+static inline u8	_send_pong(mock_server *srv, const u64 sent, const u64 received);
+static inline u8	_send_game_over(mock_server *srv);
+static inline u8	_sleep_until(mock_server *srv, const u64 deadline);
+
+u8	mock_init(mock_server *srv, const mock_config *config, const char *addr, const u16 port) {
+	struct sockaddr_in	sa;
+	socklen_t			len;
+	const i32			one = 1;
+	u8					i;
+
+	memset(srv, 0, sizeof(*srv));
+	srv->config = *config;
+	srv->stop = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	srv->udp = -1;
+	for (i = 0; i < 3; i++) {
+		srv->listen[i] = -1;
+		srv->clients[i] = -1;
+	}
+	if (srv->stop == -1)
+		return 0;
+	for (i = 0; i < 3; i++) {
+		sa = (struct sockaddr_in){
+			.sin_family = AF_INET,
+			.sin_port = htons((i == _SOCKET_STATE) ? port : 0)
+		};
+		len = sizeof(sa);
+		srv->listen[i] = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (srv->listen[i] == -1 || inet_pton(AF_INET, addr, &sa.sin_addr) != 1
+			|| setsockopt(srv->listen[i], SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == -1
+			|| bind(srv->listen[i], (struct sockaddr *)&sa, sizeof(sa)) == -1
+			|| listen(srv->listen[i], 4) == -1
+			|| getsockname(srv->listen[i], (struct sockaddr *)&sa, &len) == -1)
+			return 0;
+		srv->ports[i] = ntohs(sa.sin_port);
+	}
+	if (!config->udp)
+		return 1;
+	// the datagram channel shares the state port number
+	sa.sin_port = htons(srv->ports[_SOCKET_STATE]);
+	srv->udp = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	return (srv->udp != -1 && bind(srv->udp, (struct sockaddr *)&sa, sizeof(sa)) != -1) ? 1 : 0;
+}
+
+u8	mock_run(mock_server *srv) {
+	message	msg;
+	u64		start;
+	u64		stall;
+	u64		next;
+	u64		tick;
+	u32		burst;
+	u32		i;
+	u8		rv;
+
+	if (!srv->config.rate)
+		return 0;
+	if (!_accept(srv, _SOCKET_STATE))
+		return 0;
+	srv->version = srv->config.version;
+	srv->datagram.ready = 0;
+	srv->datagram.seq = 0;
+	srv->datagram.token = (u32)time_ns() ^ (u32)(time_ns() >> 32);
+	srv->datagram.rng = srv->datagram.token | 1;
+	msg = (message){
+		.version = srv->version,
+		.type = MESSAGE_SERVER_GAME_INIT,
+		.length = (srv->udp != -1) ? sizeof(msg_srv_init) : MESSAGE_SERVER_INIT_SIZE
+	};
+	msg.body.init = (msg_srv_init){
+		.p1_port = srv->ports[_SOCKET_P1],
+		.p2_port = srv->ports[_SOCKET_P2],
+		.udp_port = (srv->udp != -1) ? srv->ports[_SOCKET_STATE] : 0,
+		.udp_token = srv->datagram.token
+	};
+	if (!_send(srv->clients[_SOCKET_STATE], &msg) || !_accept(srv, _SOCKET_P1) || !_accept(srv, _SOCKET_P2))
+		return 0;
+	srv->paddles[0] = _FIELD_Y / 2;
+	srv->paddles[1] = _FIELD_Y / 2;
+	srv->scores[0] = 0;
+	srv->scores[1] = 0;
+	srv->inputs[0] = 0;
+	srv->inputs[1] = 0;
+	srv->rx_len[0] = 0;
+	srv->rx_len[1] = 0;
+	srv->human = 0;
+	srv->paused = 0;
+	srv->status = 0;
+	srv->actor = 0;
+	srv->primed = 0;
+	_serve(srv, 1.0f);
+	tick = 1000000000UL / srv->config.rate;
+	burst = 1;
+	if (srv->config.pattern == MOCK_PATTERN_BURST)
+		burst = (srv->config.burst) ? srv->config.burst : MOCK_BURST_SIZE;
+	start = time_ns();
+	stall = start + srv->config.stall_every * 1000000UL;
+	rv = 1;
+	for (next = start; rv && !srv->status; ) {
+		if (srv->config.duration && next - start >= srv->config.duration * 1000000000UL)
+			break ;
+		if (srv->config.close_after && next - start >= srv->config.close_after * 1000000UL) {
+			srv->status = GAME_OVER_SERVER_CLOSED;
+			break ;
+		}
+		_drain(srv);
+		if (srv->udp != -1)
+			_drain_udp(srv);
+		if (srv->clients[_SOCKET_P1] == -1 && srv->clients[_SOCKET_P2] == -1)
+			break ;
+		for (i = 0; rv && !srv->status && !srv->paused && i < burst; i++) {
+			_step(srv, (f32)tick / 1000000000.0f);
+			rv = _send_state(srv);
+		}
+		next += tick * burst;
+		if (srv->config.stall_every && next >= stall) {
+			next += srv->config.stall_ms * 1000000UL;
+			stall = next + srv->config.stall_every * 1000000UL;
+		}
+		if (rv)
+			rv = _sleep_until(srv, next);
+	}
+	if (rv && srv->status != GAME_OVER_SERVER_CLOSED)
+		rv = _send_game_over(srv);
+	for (i = 0; i < 3; i++) {
+		if (srv->clients[i] != -1)
+			close(srv->clients[i]);
+		srv->clients[i] = -1;
+	}
+	return rv;
+}
+
+void	mock_stop(mock_server *srv) {
+	const u64	wake = 1;
+
+	if (write(srv->stop, &wake, sizeof(wake)) == -1) { ; }
+}
+
+void	mock_close(mock_server *srv) {
+	u8	i;
+
+	for (i = 0; i < 3; i++) {
+		if (srv->clients[i] != -1)
+			close(srv->clients[i]);
+		if (srv->listen[i] != -1)
+			close(srv->listen[i]);
+		srv->clients[i] = -1;
+		srv->listen[i] = -1;
+	}
+	if (srv->stop != -1)
+		close(srv->stop);
+	if (srv->udp != -1)
+		close(srv->udp);
+	srv->stop = -1;
+	srv->udp = -1;
+}
+
+static inline u8	_accept(mock_server *srv, const u8 i) {
+	struct pollfd	fds[2];
+
+	fds[0] = (struct pollfd){.fd = srv->listen[i], .events = POLLIN};
+	fds[1] = (struct pollfd){.fd = srv->stop, .events = POLLIN};
+	while (poll(fds, 2, -1) == -1)
+		if (errno != EINTR)
+			return 0;
+	if (fds[1].revents & POLLIN)
+		return 0;
+	srv->clients[i] = accept(srv->listen[i], NULL, NULL);
+	return (srv->clients[i] != -1) ? 1 : 0;
+}
+
+static inline u8	_send(const i32 socket, const message *msg) {
+	size_t	size;
+	size_t	sent;
+	ssize_t	n;
+
+	size = MESSAGE_HEADER_SIZE + msg->length;
+	for (sent = 0; sent < size; sent += n) {
+		n = send(socket, (const u8 *)msg + sent, size - sent, MSG_NOSIGNAL);
+		if (n == -1 && errno != EINTR)
+			return 0;
+		if (n == -1)
+			n = 0;
+	}
+	return 1;
+}
+
+static inline void	_drain(mock_server *srv) {
+	u8		buf[256];
+	ssize_t	n;
+	u8		i;
+
+	for (i = _SOCKET_P1; i <= _SOCKET_P2; i++) {
+		if (srv->clients[i] == -1)
+			continue ;
+		do
+			n = recv(srv->clients[i], buf, sizeof(buf), MSG_DONTWAIT);
+		while (n > 0 && _parse(srv, i - _SOCKET_P1, buf, n));
+		if (n >= 0 || (errno != EAGAIN && errno != EINTR)) {
+			close(srv->clients[i]);
+			srv->clients[i] = -1;
+		}
+	}
+}
+
+static inline void	_drain_udp(mock_server *srv) {
+	struct sockaddr_storage	peer;
+	socklen_t				len;
+	u32						token;
+
+	len = sizeof(peer);
+	while (recvfrom(srv->udp, &token, sizeof(token), MSG_DONTWAIT, (struct sockaddr *)&peer, &len) == sizeof(token)) {
+		if (token == srv->datagram.token) {
+			srv->datagram.peer = peer;
+			srv->datagram.len = len;
+			srv->datagram.ready = 1;
+		}
+		len = sizeof(peer);
+	}
+}
+
+static inline u8	_parse(mock_server *srv, const u8 player, const u8 *buf, size_t len) {
+	const message	*msg;
+	size_t			want;
+	size_t			n;
+
+	msg = (const message *)srv->rx[player];
+	while (len) {
+		want = MESSAGE_HEADER_SIZE;
+		if (srv->rx_len[player] >= MESSAGE_HEADER_SIZE)
+			want += msg->length;
+		if (want > sizeof(srv->rx[player]))
+			return 0;
+		n = (want - srv->rx_len[player] < len) ? want - srv->rx_len[player] : len;
+		memcpy(&srv->rx[player][srv->rx_len[player]], buf, n);
+		srv->rx_len[player] += n;
+		buf += n;
+		len -= n;
+		if (srv->rx_len[player] >= MESSAGE_HEADER_SIZE && srv->rx_len[player] == MESSAGE_HEADER_SIZE + msg->length) {
+			srv->rx_len[player] = 0;
+			if (!_handle(srv, player, msg))
+				return 0;
+		}
+	}
+	return 1;
+}
+
+static inline u8	_handle(mock_server *srv, const u8 player, const message *msg) {
+	// clients answer with the highest version they understand
+	if (msg->version < srv->version) {
+		srv->version = msg->version;
+		srv->primed = 0;
+	}
+	switch (msg->type) {
+		case MESSAGE_CLIENT_START:
+			if (!srv->paused)
+				break ;
+			srv->paused = 0;
+			return _send_paused(srv);
+		case MESSAGE_CLIENT_PAUSE:
+			srv->paused = !srv->paused;
+			return _send_paused(srv);
+		case MESSAGE_CLIENT_MOVE_PADDLE:
+			if (msg->length != sizeof(msg_clt_move_paddle))
+				return 0;
+			srv->inputs[player] = msg->body.move_paddle.direction;
+			srv->human |= 1U << player;
+			break ;
+		case MESSAGE_CLIENT_QUIT:
+			srv->status = GAME_OVER_ACT_QUIT;
+			srv->actor = player + 1;
+			break ;
+		case MESSAGE_CLIENT_PING:
+			if (msg->length != sizeof(msg_clt_ping))
+				return 0;
+			return _send_pong(srv, msg->body.ping.sent, wall_ns());
+		default:
+			return 0;
+	}
+	return 1;
+}
+
+static inline void	_step(mock_server *srv, const f32 dt) {
+	f32	*paddle;
+	f32	target;
+	u8	side;
+	u8	i;
+
+	for (i = 0; i < 2; i++) {
+		paddle = &srv->paddles[i];
+		target = srv->ball.y;
+		if (srv->human & (1U << i))
+			*paddle += _PADDLE_SPEED * dt * ((srv->inputs[i] == _MOVE_UP) - (srv->inputs[i] == _MOVE_DOWN));
+		else if (target > *paddle + _PADDLE_SPEED * dt)
+			*paddle += _PADDLE_SPEED * dt;
+		else if (target < *paddle - _PADDLE_SPEED * dt)
+			*paddle -= _PADDLE_SPEED * dt;
+		else
+			*paddle = target;
+		if (*paddle < _PADDLE_HALF_HEIGHT)
+			*paddle = _PADDLE_HALF_HEIGHT;
+		else if (*paddle > _FIELD_Y - _PADDLE_HALF_HEIGHT)
+			*paddle = _FIELD_Y - _PADDLE_HALF_HEIGHT;
+	}
+	srv->ball.x += srv->ball.dx * dt;
+	srv->ball.y += srv->ball.dy * dt;
+	if (srv->ball.y < 0.0f || srv->ball.y > _FIELD_Y) {
+		srv->ball.y = (srv->ball.y < 0.0f) ? -srv->ball.y : 2 * _FIELD_Y - srv->ball.y;
+		srv->ball.dy = -srv->ball.dy;
+	}
+	if (srv->ball.x > 0.0f && srv->ball.x < _FIELD_X)
+		return ;
+	side = (srv->ball.x <= 0.0f) ? 0 : 1;
+	if (srv->ball.y >= srv->paddles[side] - _PADDLE_HALF_HEIGHT && srv->ball.y <= srv->paddles[side] + _PADDLE_HALF_HEIGHT) {
+		srv->ball.x = (side == 0) ? -srv->ball.x : 2 * _FIELD_X - srv->ball.x;
+		srv->ball.dx = -srv->ball.dx;
+		return ;
+	}
+	srv->scores[!side]++;
+	if (srv->config.max_score && srv->scores[!side] >= srv->config.max_score) {
+		srv->status = GAME_OVER_ACT_WON;
+		srv->actor = !side + 1;
+	}
+	_serve(srv, (side == 0) ? 1.0f : -1.0f);
+}
+
+static inline void	_serve(mock_server *srv, const f32 direction) {
+	srv->ball.x = _FIELD_X / 2;
+	srv->ball.y = _FIELD_Y / 2;
+	srv->ball.dx = _BALL_SPEED_X * direction;
+	srv->ball.dy = _BALL_SPEED_Y * ((srv->scores[0] + srv->scores[1]) % 2 ? 1.0f : -1.0f);
+}
+
+static inline u8	_send_state(mock_server *srv) {
+	message	msg;
+
+	msg = (message){
+		.version = srv->version,
+		.type = MESSAGE_SERVER_STATE_UPDATE,
+		.length = sizeof(msg_srv_state)
+	};
+	msg.body.state = (msg_srv_state){
+		.p1_paddle = srv->paddles[0],
+		.p2_paddle = srv->paddles[1],
+		.ball = {.x = srv->ball.x, .y = srv->ball.y},
+		.score = (u16)srv->scores[0] << 8 | srv->scores[1]
+	};
+	srv->sent++;
+	if (srv->datagram.ready)
+		return _send_datagram(srv, &msg);
+	if (srv->version >= 2)
+		_encode_v2(srv, &msg);
+	return _send(srv->clients[_SOCKET_STATE], &msg);
+}
+
+static inline u8	_send_datagram(mock_server *srv, message *msg) {
+	u8	buf[MESSAGE_UDP_SEQ_SIZE + sizeof(*msg)];
+
+	// datagrams may be lost, so every v2 update has to stand on its own
+	srv->primed = 0;
+	if (srv->version >= 2)
+		_encode_v2(srv, msg);
+	srv->datagram.seq++;
+	srv->datagram.rng ^= srv->datagram.rng << 13;
+	srv->datagram.rng ^= srv->datagram.rng >> 17;
+	srv->datagram.rng ^= srv->datagram.rng << 5;
+	if (srv->config.loss && srv->datagram.rng % 100 < srv->config.loss)
+		return 1;
+	memcpy(buf, &srv->datagram.seq, MESSAGE_UDP_SEQ_SIZE);
+	memcpy(&buf[MESSAGE_UDP_SEQ_SIZE], msg, MESSAGE_HEADER_SIZE + msg->length);
+	if (sendto(srv->udp, buf, MESSAGE_UDP_SEQ_SIZE + MESSAGE_HEADER_SIZE + msg->length, MSG_DONTWAIT,
+			(struct sockaddr *)&srv->datagram.peer, srv->datagram.len) == -1 && errno != EAGAIN && errno != ENOBUFS)
+		return 0;
+	return 1;
+}
+
+static inline void	_encode_v2(mock_server *srv, message *msg) {
+	const msg_srv_state	state = msg->body.state;
+	const f32			positions[4] = {state.p1_paddle, state.p2_paddle, state.ball.x, state.ball.y};
+	u8					*fields;
+	i16					q;
+	u8					flags;
+	u8					i;
+
+	fields = msg->body.state_v2.fields;
+	for (i = 0, flags = 0; i < 4; i++) {
+		q = _quantize(positions[i]);
+		if (srv->primed && q == srv->quantized[i])
+			continue ;
+		srv->quantized[i] = q;
+		memcpy(fields, &q, sizeof(q));
+		fields += sizeof(q);
+		flags |= 1U << i;
+	}
+	if (!srv->primed || state.score != srv->score) {
+		srv->score = state.score;
+		memcpy(fields, &srv->score, sizeof(srv->score));
+		fields += sizeof(srv->score);
+		flags |= STATE_V2_SCORE;
+	}
+	srv->primed = 1;
+	msg->body.state_v2.flags = flags;
+	msg->length = fields - (u8 *)&msg->body;
+}
+
+static inline i16	_quantize(const f32 n) {
+	const f32	q = roundf(n * STATE_V2_SCALE);
+
+	if (q >= INT16_MAX)
+		return INT16_MAX;
+	return (q <= INT16_MIN) ? INT16_MIN : (i16)q;
+}
+
+static inline u8	_send_paused(mock_server *srv) {
+	message	msg;
+
+	msg = (message){
+		.version = srv->version,
+		.type = MESSAGE_SERVER_GAME_PAUSED,
+		.length = 0
+	};
+	return _send(srv->clients[_SOCKET_STATE], &msg);
+}
+
+static inline u8	_send_pong(mock_server *srv, const u64 sent, const u64 received) {
+	message	msg;
+
+	msg = (message){
+		.version = srv->version,
+		.type = MESSAGE_SERVER_PONG,
+		.length = sizeof(msg_srv_pong)
+	};
+	msg.body.pong = (msg_srv_pong){
+		.sent = sent,
+		.received = received,
+		.replied = wall_ns()
+	};
+	return _send(srv->clients[_SOCKET_STATE], &msg);
+}
+
+static inline u8	_send_game_over(mock_server *srv) {
+	message	msg;
+	u8		winner;
+
+	if (!srv->status) {
+		srv->status = GAME_OVER_ACT_WON;
+		srv->actor = (srv->scores[0] >= srv->scores[1]) ? 1 : 2;
+	}
+	winner = (srv->status == GAME_OVER_ACT_QUIT) ? 3 - srv->actor : srv->actor;
+	msg = (message){
+		.version = srv->version,
+		.type = MESSAGE_SERVER_GAME_OVER
+	};
+	switch (srv->version) {
+		case 0:
+			msg.length = sizeof(msg_srv_game_over_v0);
+			msg.body.game_over.v0.winner_id = winner;
+			break ;
+		default:
+			msg.length = sizeof(msg_srv_game_over_v1);
+			msg.body.game_over.v1 = (msg_srv_game_over_v1){
+				.actor_id = srv->actor,
+				.finish_status = srv->status,
+				.score = (u16)srv->scores[0] << 8 | srv->scores[1]
+			};
+	}
+	return _send(srv->clients[_SOCKET_STATE], &msg);
+}
+
+static inline u8	_sleep_until(mock_server *srv, const u64 deadline) {
+	struct timespec	ts;
+	struct pollfd	pfd;
+	u64				now;
+
+	pfd = (struct pollfd){.fd = srv->stop, .events = POLLIN};
+	now = time_ns();
+	if (poll(&pfd, 1, (deadline > now + 1000000) ? (deadline - now) / 1000000 : 0) == -1 && errno != EINTR)
+		return 0;
+	if (pfd.revents & POLLIN)
+		return 0;
+	ts = (struct timespec){.tv_sec = deadline / 1000000000UL, .tv_nsec = deadline % 1000000000UL};
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		;
+	return 1;
+}
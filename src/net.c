@@ -0,0 +1,521 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<net.c>>
+
+#include <poll.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#include "net.h"
+#include "utils.h"
+
+#define _BODY_UNKNOWN	SIZE_MAX
+
+// compact once less than this much room is left at the tail
+#define _RX_LOW_WATER	(NET_RX_BUFFER_SIZE / 4)
+
+static const struct addrinfo	_hints = {
+	.ai_family = AF_UNSPEC,
+	.ai_socktype = SOCK_STREAM,
+	.ai_flags = AI_ADDRCONFIG
+};
+
+static inline i32		_connect_start(const net_addrs *addrs, const u8 i, const u16 port);
+static inline size_t	_body_size(const u8 type, const u8 version);
+static inline size_t	_msg_size(const message *msg);
+static inline size_t	_v2_size(const u8 flags);
+static inline const message	*_expand(net_rx *rx, const message *msg, const size_t size);
+
+u8	net_resolve(net_addrs *addrs, const char *host) {
+	struct addrinfo	*res;
+	struct addrinfo	*cur;
+	struct addrinfo	*queue[NET_ADDRS_MAX];
+	u8				count;
+	u8				i;
+	u8				j;
+
+	if (addrs->count && strncmp(addrs->host, host, sizeof(addrs->host)) == 0)
+		return 1;
+	addrs->count = 0;
+	if (getaddrinfo(host, NULL, &_hints, &res) != 0)
+		return 0;
+	for (count = 0, cur = res; cur && count < NET_ADDRS_MAX; cur = cur->ai_next)
+		if (cur->ai_addrlen <= sizeof(*addrs->addrs))
+			queue[count++] = cur;
+	// interleave address families so a dead family costs at most one stagger
+	for (i = 0; i < count; i++) {
+		if (i == 0 || queue[i]->ai_family != queue[i - 1]->ai_family)
+			continue ;
+		for (j = i + 1; j < count && queue[j]->ai_family == queue[i - 1]->ai_family; j++)
+			;
+		if (j == count)
+			break ;
+		cur = queue[j];
+		memmove(&queue[i + 1], &queue[i], (j - i) * sizeof(*queue));
+		queue[i] = cur;
+	}
+	for (i = 0; i < count; i++) {
+		memcpy(&addrs->addrs[i], queue[i]->ai_addr, queue[i]->ai_addrlen);
+		addrs->lens[i] = queue[i]->ai_addrlen;
+	}
+	freeaddrinfo(res);
+	if (!count)
+		return 0;
+	strncpy(addrs->host, host, sizeof(addrs->host) - 1);
+	addrs->host[sizeof(addrs->host) - 1] = '\0';
+	addrs->count = count;
+	return 1;
+}
+
+// numeric ports or tcp service names, 0 when neither resolves
+u16	net_port(const char *port) {
+	struct servent	*serv;
+	char			*end;
+	u64				n;
+
+	if (!port || !*port)
+		return 0;
+	n = strtoul(port, &end, 10);
+	if (!*end)
+		return (n <= UINT16_MAX) ? n : 0;
+	serv = getservbyname(port, "tcp");
+	return (serv) ? ntohs(serv->s_port) : 0;
+}
+
+u8	net_connect(const net_addrs *addrs, const u16 *ports, i32 *sockets, const u8 n, const u64 timeout_ns) {
+	struct pollfd	fds[NET_CONNECT_MAX * NET_ADDRS_MAX];
+	u64				launch[NET_CONNECT_MAX];
+	u64				deadline;
+	u64				now;
+	u64				wait;
+	i32				err;
+	socklen_t		len;
+	u8				next[NET_CONNECT_MAX];
+	u8				live;
+	u8				t;
+	u8				i;
+
+	if (n > NET_CONNECT_MAX)
+		return 0;
+	for (i = 0; i < n * NET_ADDRS_MAX; i++)
+		fds[i] = (struct pollfd){.fd = -1, .events = POLLOUT};
+	for (t = 0; t < n; t++) {
+		sockets[t] = -1;
+		launch[t] = 0;
+		next[t] = 0;
+	}
+	deadline = time_ns() + timeout_ns;
+	while (1) {
+		now = time_ns();
+		wait = deadline;
+		for (t = live = 0; t < n; t++) {
+			if (sockets[t] != -1)
+				continue ;
+			while (next[t] < addrs->count && now >= launch[t]) {
+				i = t * NET_ADDRS_MAX + next[t];
+				fds[i].fd = _connect_start(addrs, next[t]++, ports[t]);
+				launch[t] = now + NET_CONNECT_STAGGER_MS * 1000000UL;
+				if (fds[i].fd != -1)
+					break ;
+				launch[t] = now;
+			}
+			for (i = 0; i < addrs->count && fds[t * NET_ADDRS_MAX + i].fd == -1; i++)
+				;
+			if (i == addrs->count && next[t] == addrs->count)
+				goto fail;
+			if (next[t] < addrs->count && launch[t] < wait)
+				wait = launch[t];
+			live = 1;
+		}
+		if (!live)
+			return 1;
+		if (now >= deadline)
+			goto fail;
+		wait = (wait > now) ? (wait - now + 999999) / 1000000 : 0;
+		if (poll(fds, n * NET_ADDRS_MAX, wait) == -1 && errno != EINTR)
+			goto fail;
+		for (i = 0; i < n * NET_ADDRS_MAX; i++) {
+			if (fds[i].fd == -1 || !fds[i].revents)
+				continue ;
+			t = i / NET_ADDRS_MAX;
+			len = sizeof(err);
+			if (getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1 || err != 0) {
+				close(fds[i].fd);
+				fds[i].fd = -1;
+				launch[t] = 0;
+				continue ;
+			}
+			if (sockets[t] == -1) {
+				sockets[t] = fds[i].fd;
+				fds[i].fd = -1;
+			}
+		}
+		for (i = 0; i < n * NET_ADDRS_MAX; i++) {
+			if (fds[i].fd != -1 && sockets[i / NET_ADDRS_MAX] != -1) {
+				close(fds[i].fd);
+				fds[i].fd = -1;
+			}
+		}
+	}
+fail:
+	for (i = 0; i < n * NET_ADDRS_MAX; i++)
+		if (fds[i].fd != -1)
+			close(fds[i].fd);
+	for (t = 0; t < n; t++) {
+		if (sockets[t] != -1)
+			close(sockets[t]);
+		sockets[t] = -1;
+	}
+	return 0;
+}
+
+i32	net_connect_start(const net_addrs *addrs, const u8 i, const u16 port) {
+	return (i < addrs->count) ? _connect_start(addrs, i, port) : -1;
+}
+
+void	net_rx_reset(net_rx *rx) {
+	rx->head = 0;
+	rx->tail = 0;
+	rx->skip = 0;
+	memset(&rx->base, 0, sizeof(rx->base));
+}
+
+u8	*net_rx_space(net_rx *rx, size_t *room) {
+	if (rx->head == rx->tail) {
+		rx->head = 0;
+		rx->tail = 0;
+	} else if (rx->head && NET_RX_BUFFER_SIZE - rx->tail < _RX_LOW_WATER) {
+		memmove(rx->buf, &rx->buf[rx->head], rx->tail - rx->head);
+		rx->tail -= rx->head;
+		rx->head = 0;
+	}
+	*room = NET_RX_BUFFER_SIZE - rx->tail;
+	return &rx->buf[rx->tail];
+}
+
+void	net_rx_commit(net_rx *rx, const size_t n) {
+	rx->tail += n;
+}
+
+ssize_t	net_rx_fill(net_rx *rx, const i32 socket, const i32 flags) {
+	ssize_t	n;
+	size_t	room;
+	u8		*buf;
+
+	buf = net_rx_space(rx, &room);
+	if (!room) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	n = recv(socket, buf, room, flags);
+	if (n > 0)
+		net_rx_commit(rx, n);
+	return n;
+}
+
+const message	*net_rx_next(net_rx *rx, const u8 version) {
+	const message	*msg;
+	size_t			available;
+	size_t			body;
+	size_t			size;
+
+	while (1) {
+		available = rx->tail - rx->head;
+		if (rx->skip) {
+			size = (rx->skip < available) ? rx->skip : available;
+			rx->head += size;
+			rx->skip -= size;
+			if (rx->skip)
+				return NULL;
+			continue ;
+		}
+		if (available < MESSAGE_HEADER_SIZE)
+			return NULL;
+		msg = (const message *)&rx->buf[rx->head];
+		body = _body_size(msg->type, version);
+		size = msg->length;
+		// older servers leave length at zero, fall back to the known body size
+		if (size == 0 && body != _BODY_UNKNOWN)
+			size = body;
+		if (body == _BODY_UNKNOWN || size < body || MESSAGE_HEADER_SIZE + size > NET_RX_BUFFER_SIZE) {
+			rx->head += MESSAGE_HEADER_SIZE;
+			rx->skip = size;
+			continue ;
+		}
+		if (available < MESSAGE_HEADER_SIZE + size)
+			return NULL;
+		rx->head += MESSAGE_HEADER_SIZE + size;
+		if (version >= 2 && msg->type == MESSAGE_SERVER_STATE_UPDATE && !(msg = _expand(rx, msg, size)))
+			continue ;
+		return msg;
+	}
+}
+
+void	net_init_body(const message *msg, msg_srv_init *init) {
+	memset(init, 0, sizeof(*init));
+	memcpy(init, &msg->body, (msg->length < sizeof(*init)) ? msg->length : sizeof(*init));
+	// length zero means an old server with the bare port pair
+	if (!msg->length)
+		memcpy(init, &msg->body, MESSAGE_SERVER_INIT_SIZE);
+}
+
+u8	net_udp_open(net_udp *udp, const i32 peer, const u16 port, const u32 token) {
+	struct sockaddr_storage	addr;
+	socklen_t				len;
+
+	udp->socket = -1;
+	udp->primed = 0;
+	udp->dropped = 0;
+	udp->token = token;
+	len = sizeof(addr);
+	if (!port || getpeername(peer, (struct sockaddr *)&addr, &len) == -1)
+		return 0;
+	if (addr.ss_family == AF_INET6)
+		((struct sockaddr_in6 *)&addr)->sin6_port = htons(port);
+	else
+		((struct sockaddr_in *)&addr)->sin_port = htons(port);
+	udp->socket = socket(addr.ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (udp->socket == -1)
+		return 0;
+	if (connect(udp->socket, (struct sockaddr *)&addr, len) == -1) {
+		net_udp_close(udp);
+		return 0;
+	}
+	return 1;
+}
+
+// the token lets the server tie this datagram's source address to the session
+u8	net_udp_hello(net_udp *udp) {
+	return (send(udp->socket, &udp->token, sizeof(udp->token), MSG_NOSIGNAL) == sizeof(udp->token)) ? 1 : 0;
+}
+
+const message	*net_udp_next(net_udp *udp, const u8 version) {
+	const message	*msg;
+	const message	*raw;
+	ssize_t			n;
+	u32				seq;
+
+	while (1) {
+		n = recv(udp->socket, udp->rx.buf, sizeof(udp->rx.buf), MSG_DONTWAIT);
+		if (n == -1)
+			return NULL;
+		if (n < MESSAGE_UDP_SEQ_SIZE + MESSAGE_HEADER_SIZE)
+			continue ;
+		memcpy(&seq, udp->rx.buf, sizeof(seq));
+		// wrap-safe: anything not newer than the last accepted datagram is stale or a duplicate
+		if (udp->primed && (i32)(seq - udp->seq) <= 0) {
+			udp->dropped++;
+			continue ;
+		}
+		// a lost datagram would leave a delta without its base, so only full v2 states are taken
+		raw = (const message *)&udp->rx.buf[MESSAGE_UDP_SEQ_SIZE];
+		if (version >= 2 && raw->type == MESSAGE_SERVER_STATE_UPDATE
+			&& (n < MESSAGE_UDP_SEQ_SIZE + MESSAGE_HEADER_SIZE + 1 || raw->body.state_v2.flags != STATE_V2_ALL)) {
+			udp->dropped++;
+			continue ;
+		}
+		udp->rx.head = MESSAGE_UDP_SEQ_SIZE;
+		udp->rx.tail = n;
+		udp->rx.skip = 0;
+		msg = net_rx_next(&udp->rx, version);
+		if (!msg || msg->type != MESSAGE_SERVER_STATE_UPDATE)
+			continue ;
+		udp->seq = seq;
+		udp->primed = 1;
+		return msg;
+	}
+}
+
+void	net_udp_close(net_udp *udp) {
+	if (udp->socket != -1)
+		close(udp->socket);
+	udp->socket = -1;
+}
+
+void	net_clock_reset(net_clock *clock) {
+	memset(clock, 0, sizeof(*clock));
+}
+
+// NTP style: rtt excludes the server's hold time, and the offset is taken from
+// the fastest recent exchange since queueing delay skews it the least
+u8	net_clock_sample(net_clock *clock, const msg_srv_pong *pong, const u64 now) {
+	u64	rtt;
+	u64	diff;
+	u32	best;
+	u32	i;
+
+	if (now < pong->sent || pong->replied < pong->received || now - pong->sent < pong->replied - pong->received)
+		return 0;
+	rtt = (now - pong->sent) - (pong->replied - pong->received);
+	i = clock->samples++ % NET_CLOCK_WINDOW;
+	clock->window[i].rtt = rtt;
+	clock->window[i].offset = ((i64)(pong->received - pong->sent) + (i64)(pong->replied - now)) / 2;
+	if (clock->samples == 1) {
+		clock->rtt = rtt;
+		clock->rtt_var = rtt / 2;
+	} else {
+		diff = (clock->rtt > rtt) ? clock->rtt - rtt : rtt - clock->rtt;
+		clock->rtt_var = (3 * clock->rtt_var + diff) / 4;
+		clock->rtt = (7 * clock->rtt + rtt) / 8;
+	}
+	for (i = 1, best = 0; i < NET_CLOCK_WINDOW && i < clock->samples; i++)
+		if (clock->window[i].rtt < clock->window[best].rtt)
+			best = i;
+	clock->offset = clock->window[best].offset;
+	return 1;
+}
+
+void	net_tx_reset(net_tx *tx) {
+	tx->out_len = 0;
+	tx->count = 0;
+}
+
+void	net_tx_consume(net_tx *tx, const u8 n) {
+	memmove(tx->msgs, &tx->msgs[n], (tx->count - n) * sizeof(*tx->msgs));
+	tx->count -= n;
+}
+
+u8	net_tx_push(net_tx *tx, const message *msg) {
+	if (tx->count && msg->type == MESSAGE_CLIENT_MOVE_PADDLE
+		&& tx->msgs[tx->count - 1].type == MESSAGE_CLIENT_MOVE_PADDLE) {
+		tx->msgs[tx->count - 1] = *msg;
+		return 1;
+	}
+	if (tx->count == NET_TX_BATCH)
+		return 0;
+	tx->msgs[tx->count++] = *msg;
+	return 1;
+}
+
+i8	net_tx_flush(net_tx *tx, const i32 socket) {
+	struct iovec	iov[NET_TX_BATCH + 1];
+	struct msghdr	hdr;
+	ssize_t			sent;
+	size_t			total;
+	size_t			skip;
+	size_t			len;
+	size_t			i;
+	u8				rest[sizeof(tx->out)];
+	u8				count;
+
+	i = 0;
+	total = tx->out_len;
+	if (tx->out_len)
+		iov[i++] = (struct iovec){.iov_base = tx->out, .iov_len = tx->out_len};
+	for (count = 0; count < tx->count && total + _msg_size(&tx->msgs[count]) <= sizeof(tx->out); count++) {
+		iov[i++] = (struct iovec){.iov_base = &tx->msgs[count], .iov_len = _msg_size(&tx->msgs[count])};
+		total += _msg_size(&tx->msgs[count]);
+	}
+	if (!i)
+		return 1;
+	hdr = (struct msghdr){.msg_iov = iov, .msg_iovlen = i};
+	sent = sendmsg(socket, &hdr, MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (sent == -1)
+		return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+	for (len = 0, skip = sent, i = 0; i < hdr.msg_iovlen; i++) {
+		if (skip >= iov[i].iov_len) {
+			skip -= iov[i].iov_len;
+			continue ;
+		}
+		memcpy(&rest[len], (u8 *)iov[i].iov_base + skip, iov[i].iov_len - skip);
+		len += iov[i].iov_len - skip;
+		skip = 0;
+	}
+	memcpy(tx->out, rest, len);
+	tx->out_len = len;
+	memmove(tx->msgs, &tx->msgs[count], (tx->count - count) * sizeof(*tx->msgs));
+	tx->count -= count;
+	return (!tx->out_len && !tx->count) ? 1 : 0;
+}
+
+static inline i32	_connect_start(const net_addrs *addrs, const u8 i, const u16 port) {
+	struct sockaddr_storage	addr;
+	i32						fd;
+
+	addr = addrs->addrs[i];
+	if (addr.ss_family == AF_INET6)
+		((struct sockaddr_in6 *)&addr)->sin6_port = htons(port);
+	else
+		((struct sockaddr_in *)&addr)->sin_port = htons(port);
+	fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		return -1;
+	if (connect(fd, (struct sockaddr *)&addr, addrs->lens[i]) == -1 && errno != EINPROGRESS) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static inline size_t	_body_size(const u8 type, const u8 version) {
+	switch (type) {
+		case MESSAGE_SERVER_GAME_INIT:
+			return MESSAGE_SERVER_INIT_SIZE;
+		case MESSAGE_SERVER_GAME_PAUSED:
+			return 0;
+		case MESSAGE_SERVER_GAME_OVER:
+			return (version == 0) ? sizeof(msg_srv_game_over_v0) : sizeof(msg_srv_game_over_v1);
+		case MESSAGE_SERVER_STATE_UPDATE:
+			return (version >= 2) ? sizeof(u8) : sizeof(msg_srv_state);
+		case MESSAGE_SERVER_PONG:
+			return sizeof(msg_srv_pong);
+	}
+	return _BODY_UNKNOWN;
+}
+
+static inline size_t	_msg_size(const message *msg) {
+	return MESSAGE_HEADER_SIZE + msg->length;
+}
+
+static inline size_t	_v2_size(const u8 flags) {
+	size_t	size;
+	u8		i;
+
+	if (flags & ~STATE_V2_ALL)
+		return _BODY_UNKNOWN;
+	for (i = 0, size = sizeof(flags); i < 4; i++)
+		if (flags & (1U << i))
+			size += sizeof(i16);
+	return (flags & STATE_V2_SCORE) ? size + sizeof(u16) : size;
+}
+
+// fields missing from a v2 update are unchanged since the previous one
+static inline const message	*_expand(net_rx *rx, const message *msg, const size_t size) {
+	const u8	*fields;
+	f32			positions[4];
+	i16			q;
+	u8			i;
+
+	if (size != _v2_size(msg->body.state_v2.flags))
+		return NULL;
+	// p1, p2, ball x and ball y are laid out back to back in flag order
+	memcpy(positions, &rx->base, sizeof(positions));
+	fields = msg->body.state_v2.fields;
+	for (i = 0; i < 4; i++) {
+		if (!(msg->body.state_v2.flags & (1U << i)))
+			continue ;
+		memcpy(&q, fields, sizeof(q));
+		positions[i] = q / STATE_V2_SCALE;
+		fields += sizeof(q);
+	}
+	memcpy(&rx->base, positions, sizeof(positions));
+	if (msg->body.state_v2.flags & STATE_V2_SCORE)
+		memcpy(&rx->base.score, fields, sizeof(rx->base.score));
+	rx->state = (message){
+		.version = msg->version,
+		.type = MESSAGE_SERVER_STATE_UPDATE,
+		.length = sizeof(msg_srv_state)
+	};
+	rx->state.body.state = rx->base;
+	return &rx->state;
+}
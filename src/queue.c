@@ -0,0 +1,61 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<queue.c>>
+
+#include <stdatomic.h>
+
+#include "queue.h"
+
+#define _MASK	(QUEUE_SIZE - 1)
+
+_Static_assert((QUEUE_SIZE & _MASK) == 0, "QUEUE_SIZE must be a power of two");
+
+void	queue_init(cmd_queue *queue) {
+	u64	i;
+
+	for (i = 0; i < QUEUE_SIZE; i++)
+		atomic_store_explicit(&queue->slots[i].seq, i, memory_order_relaxed);
+	atomic_store_explicit(&queue->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&queue->tail, 0, memory_order_release);
+}
+
+u8	queue_push(cmd_queue *queue, const command *cmd) {
+	u64	pos;
+	u64	seq;
+	i64	diff;
+
+	pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	while (1) {
+		seq = atomic_load_explicit(&queue->slots[pos & _MASK].seq, memory_order_acquire);
+		diff = (i64)seq - (i64)pos;
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+				break ;
+		} else if (diff < 0)
+			return 0;
+		else
+			pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	}
+	queue->slots[pos & _MASK].cmd = *cmd;
+	atomic_store_explicit(&queue->slots[pos & _MASK].seq, pos + 1, memory_order_release);
+	return 1;
+}
+
+u8	queue_pop(cmd_queue *queue, command *cmd) {
+	u64	pos;
+	u64	seq;
+
+	pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	seq = atomic_load_explicit(&queue->slots[pos & _MASK].seq, memory_order_acquire);
+	if ((i64)seq - (i64)(pos + 1) < 0)
+		return 0;
+	*cmd = queue->slots[pos & _MASK].cmd;
+	atomic_store_explicit(&queue->slots[pos & _MASK].seq, pos + QUEUE_SIZE, memory_order_release);
+	atomic_store_explicit(&queue->head, pos + 1, memory_order_relaxed);
+	return 1;
+}
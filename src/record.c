@@ -0,0 +1,417 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<record.c>>
+
+#include <fcntl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "record.h"
+#include "utils.h"
+
+// entry layout: u32 microseconds since the previous entry, u8 kind, then the payload
+#define _ENTRY_HEADER_SIZE	(sizeof(u32) + 1)
+#define _ENTRY_RAW			0x0U
+#define _ENTRY_DELTA		0x1U
+
+#define _DELTA_P1		0x01U
+#define _DELTA_P2		0x02U
+#define _DELTA_BALL_X	0x04U
+#define _DELTA_BALL_Y	0x08U
+#define _DELTA_SCORE	0x10U
+
+#define _FILE_HEADER_SIZE	sizeof(RECORD_MAGIC)
+#define _FOOTER_SIZE		(sizeof(u64) + sizeof(u32) + sizeof(RECORD_INDEX_MAGIC) - 1)
+
+#define _INDEX_INITIAL_CAP	64
+
+static void		*_writer(void *arg);
+static void		_put(recorder *rec, const void *data, const size_t n);
+static void		_add_key(recorder *rec, const u64 at, const u64 offset);
+static size_t	_encode_delta(u8 *out, const msg_srv_state *from, const msg_srv_state *to);
+static u8		_decode(replay *rp);
+static u8		_take(replay *rp, void *out, const size_t n);
+static void		_scan_index(replay *rp);
+
+u8	record_open(recorder *rec, const char *path) {
+	const u8	header[] = {RECORD_MAGIC[0], RECORD_MAGIC[1], RECORD_MAGIC[2], RECORD_MAGIC[3], RECORD_VERSION};
+
+	rec->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (rec->fd == -1)
+		return 0;
+	if (write(rec->fd, header, sizeof(header)) != sizeof(header)
+		|| pthread_mutex_init(&rec->lock, NULL) != 0) {
+		close(rec->fd);
+		rec->fd = -1;
+		return 0;
+	}
+	if (pthread_cond_init(&rec->cond, NULL) != 0) {
+		pthread_mutex_destroy(&rec->lock);
+		close(rec->fd);
+		rec->fd = -1;
+		return 0;
+	}
+	rec->head = 0;
+	rec->tail = 0;
+	rec->dropped = 0;
+	rec->stop = 0;
+	rec->offset = sizeof(header);
+	rec->index = NULL;
+	rec->index_count = 0;
+	rec->index_cap = 0;
+	rec->since_key = 0;
+	rec->key_due = 1;
+	rec->start = time_ns();
+	rec->last = rec->start;
+	if (pthread_create(&rec->tid, NULL, _writer, rec) != 0) {
+		pthread_cond_destroy(&rec->cond);
+		pthread_mutex_destroy(&rec->lock);
+		close(rec->fd);
+		rec->fd = -1;
+		return 0;
+	}
+	return 1;
+}
+
+void	record_push(recorder *rec, const message *msg) {
+	u8		entry[_ENTRY_HEADER_SIZE + sizeof(message)];
+	size_t	size;
+	u64		now;
+	u32		dt;
+	u8		state;
+	u8		key;
+
+	if (rec->fd == -1)
+		return ;
+	size = MESSAGE_HEADER_SIZE + msg->length;
+	if (size > sizeof(*msg))
+		size = sizeof(*msg);
+	now = time_ns();
+	dt = ((now - rec->last) / 1000 < UINT32_MAX) ? (now - rec->last) / 1000 : UINT32_MAX;
+	memcpy(entry, &dt, sizeof(dt));
+	state = (msg->type == MESSAGE_SERVER_STATE_UPDATE && msg->length == sizeof(msg_srv_state)) ? 1 : 0;
+	key = (state && (rec->key_due || rec->since_key >= RECORD_KEYFRAME_INTERVAL)) ? 1 : 0;
+	if (state && !key) {
+		entry[sizeof(dt)] = _ENTRY_DELTA;
+		size = _ENTRY_HEADER_SIZE + _encode_delta(&entry[_ENTRY_HEADER_SIZE], &rec->base, &msg->body.state);
+	} else {
+		entry[sizeof(dt)] = _ENTRY_RAW;
+		memcpy(&entry[_ENTRY_HEADER_SIZE], msg, size);
+		size += _ENTRY_HEADER_SIZE;
+	}
+	pthread_mutex_lock(&rec->lock);
+	if (RECORD_BUFFER_SIZE - 1 - (rec->tail - rec->head + RECORD_BUFFER_SIZE) % RECORD_BUFFER_SIZE < size) {
+		rec->dropped++;
+		rec->key_due = 1;
+		pthread_mutex_unlock(&rec->lock);
+		return ;
+	}
+	_put(rec, entry, size);
+	pthread_cond_signal(&rec->cond);
+	pthread_mutex_unlock(&rec->lock);
+	rec->last += (u64)dt * 1000;
+	if (key) {
+		_add_key(rec, (rec->last - rec->start) / 1000, rec->offset);
+		rec->key_due = 0;
+		rec->since_key = 0;
+	}
+	if (state) {
+		rec->base = msg->body.state;
+		rec->since_key++;
+	}
+	rec->offset += size;
+}
+
+void	record_close(recorder *rec) {
+	u8	footer[_FOOTER_SIZE];
+
+	if (rec->fd == -1)
+		return ;
+	pthread_mutex_lock(&rec->lock);
+	rec->stop = 1;
+	pthread_cond_signal(&rec->cond);
+	pthread_mutex_unlock(&rec->lock);
+	pthread_join(rec->tid, NULL);
+	pthread_cond_destroy(&rec->cond);
+	pthread_mutex_destroy(&rec->lock);
+	if (rec->head == rec->tail) {
+		memcpy(footer, &rec->offset, sizeof(u64));
+		memcpy(&footer[sizeof(u64)], &rec->index_count, sizeof(u32));
+		memcpy(&footer[sizeof(u64) + sizeof(u32)], RECORD_INDEX_MAGIC, sizeof(RECORD_INDEX_MAGIC) - 1);
+		if (write(rec->fd, rec->index, rec->index_count * sizeof(*rec->index)) == -1
+			|| write(rec->fd, footer, sizeof(footer)) == -1) { ; }
+	}
+	free(rec->index);
+	rec->index = NULL;
+	close(rec->fd);
+	rec->fd = -1;
+}
+
+u8	replay_open(replay *rp, const char *path) {
+	struct stat	st;
+	const u8	*footer;
+	u64			offset;
+	u32			count;
+	i32			fd;
+
+	rp->map = NULL;
+	rp->scanned = NULL;
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return 0;
+	if (fstat(fd, &st) == -1 || (size_t)st.st_size < _FILE_HEADER_SIZE) {
+		close(fd);
+		return 0;
+	}
+	rp->size = st.st_size;
+	rp->map = mmap(NULL, rp->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (rp->map == MAP_FAILED) {
+		rp->map = NULL;
+		return 0;
+	}
+	if (memcmp(rp->map, RECORD_MAGIC, sizeof(RECORD_MAGIC) - 1) != 0 || rp->map[sizeof(RECORD_MAGIC) - 1] != RECORD_VERSION) {
+		replay_close(rp);
+		return 0;
+	}
+	rp->index = NULL;
+	rp->index_count = 0;
+	rp->end = rp->size;
+	if (rp->size >= _FILE_HEADER_SIZE + _FOOTER_SIZE) {
+		footer = &rp->map[rp->size - _FOOTER_SIZE];
+		memcpy(&offset, footer, sizeof(offset));
+		memcpy(&count, &footer[sizeof(offset)], sizeof(count));
+		if (memcmp(&footer[sizeof(offset) + sizeof(count)], RECORD_INDEX_MAGIC, sizeof(RECORD_INDEX_MAGIC) - 1) == 0
+			&& offset >= _FILE_HEADER_SIZE && offset + (u64)count * sizeof(record_key) == rp->size - _FOOTER_SIZE) {
+			rp->index = (const record_key *)&rp->map[offset];
+			rp->index_count = count;
+			rp->end = offset;
+		}
+	}
+	madvise((void *)rp->map, rp->size, MADV_SEQUENTIAL);
+	if (!rp->index)
+		_scan_index(rp);
+	rp->pos = _FILE_HEADER_SIZE;
+	rp->at = 0;
+	rp->version = 0;
+	rp->pending = 0;
+	memset(&rp->base, 0, sizeof(rp->base));
+	return 1;
+}
+
+const message	*replay_peek(replay *rp, u64 *at) {
+	if (!rp->pending && !_decode(rp))
+		return NULL;
+	rp->pending = 1;
+	*at = rp->at;
+	return &rp->msg;
+}
+
+void	replay_skip(replay *rp) {
+	rp->pending = 0;
+}
+
+void	replay_seek(replay *rp, const u64 at) {
+	u32	lo;
+	u32	hi;
+	u32	mid;
+	u32	dt;
+
+	for (lo = 0, hi = rp->index_count; lo < hi; ) {
+		mid = lo + (hi - lo) / 2;
+		if (rp->index[mid].at <= at / 1000)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	// seeks before the first state land on it, so GAME_INIT is never fed twice
+	if (!lo)
+		lo = 1;
+	if (lo > rp->index_count || rp->index[lo - 1].offset + sizeof(dt) > rp->end)
+		return ;
+	rp->pending = 0;
+	rp->pos = rp->index[lo - 1].offset;
+	memcpy(&dt, &rp->map[rp->pos], sizeof(dt));
+	rp->at = (rp->index[lo - 1].at - dt) * 1000;
+}
+
+void	replay_close(replay *rp) {
+	if (rp->map)
+		munmap((void *)rp->map, rp->size);
+	free(rp->scanned);
+	rp->map = NULL;
+	rp->scanned = NULL;
+	rp->index = NULL;
+	rp->index_count = 0;
+}
+
+static void	*_writer(void *arg) {
+	recorder	*rec;
+	ssize_t		n;
+	size_t		end;
+
+	rec = arg;
+	pthread_mutex_lock(&rec->lock);
+	while (1) {
+		while (rec->head == rec->tail && !rec->stop)
+			pthread_cond_wait(&rec->cond, &rec->lock);
+		if (rec->head == rec->tail)
+			break ;
+		end = (rec->tail > rec->head) ? rec->tail : RECORD_BUFFER_SIZE;
+		pthread_mutex_unlock(&rec->lock);
+		n = write(rec->fd, &rec->buf[rec->head], end - rec->head);
+		pthread_mutex_lock(&rec->lock);
+		if (n == -1 && errno != EINTR)
+			break ;
+		if (n > 0)
+			rec->head = (rec->head + n) % RECORD_BUFFER_SIZE;
+	}
+	pthread_mutex_unlock(&rec->lock);
+	return NULL;
+}
+
+static void	_put(recorder *rec, const void *data, const size_t n) {
+	size_t	chunk;
+
+	chunk = (RECORD_BUFFER_SIZE - rec->tail < n) ? RECORD_BUFFER_SIZE - rec->tail : n;
+	memcpy(&rec->buf[rec->tail], data, chunk);
+	memcpy(rec->buf, (const u8 *)data + chunk, n - chunk);
+	rec->tail = (rec->tail + n) % RECORD_BUFFER_SIZE;
+}
+
+static void	_add_key(recorder *rec, const u64 at, const u64 offset) {
+	record_key	*index;
+	u32			cap;
+
+	if (rec->index_count == rec->index_cap) {
+		cap = (rec->index_cap) ? rec->index_cap * 2 : _INDEX_INITIAL_CAP;
+		index = realloc(rec->index, cap * sizeof(*index));
+		if (!index)
+			return ;
+		rec->index = index;
+		rec->index_cap = cap;
+	}
+	rec->index[rec->index_count++] = (record_key){
+		.at = at,
+		.offset = offset
+	};
+}
+
+static size_t	_encode_delta(u8 *out, const msg_srv_state *from, const msg_srv_state *to) {
+	size_t	n;
+
+	n = 1;
+	out[0] = 0;
+	if (memcmp(&from->p1_paddle, &to->p1_paddle, sizeof(f32)) != 0) {
+		memcpy(&out[n], &to->p1_paddle, sizeof(f32));
+		n += sizeof(f32);
+		out[0] |= _DELTA_P1;
+	}
+	if (memcmp(&from->p2_paddle, &to->p2_paddle, sizeof(f32)) != 0) {
+		memcpy(&out[n], &to->p2_paddle, sizeof(f32));
+		n += sizeof(f32);
+		out[0] |= _DELTA_P2;
+	}
+	if (memcmp(&from->ball.x, &to->ball.x, sizeof(f32)) != 0) {
+		memcpy(&out[n], &to->ball.x, sizeof(f32));
+		n += sizeof(f32);
+		out[0] |= _DELTA_BALL_X;
+	}
+	if (memcmp(&from->ball.y, &to->ball.y, sizeof(f32)) != 0) {
+		memcpy(&out[n], &to->ball.y, sizeof(f32));
+		n += sizeof(f32);
+		out[0] |= _DELTA_BALL_Y;
+	}
+	if (from->score != to->score) {
+		memcpy(&out[n], &to->score, sizeof(u16));
+		n += sizeof(u16);
+		out[0] |= _DELTA_SCORE;
+	}
+	return n;
+}
+
+static u8	_decode(replay *rp) {
+	msg_srv_state	*state;
+	size_t			pos;
+	u32				dt;
+	u8				kind;
+	u8				mask;
+
+	pos = rp->pos;
+	if (!_take(rp, &dt, sizeof(dt)) || !_take(rp, &kind, sizeof(kind)))
+		return 0;
+	switch (kind) {
+		case _ENTRY_RAW:
+			if (!_take(rp, &rp->msg, MESSAGE_HEADER_SIZE) || (size_t)MESSAGE_HEADER_SIZE + rp->msg.length > sizeof(rp->msg)
+				|| !_take(rp, &rp->msg.body, rp->msg.length))
+				break ;
+			rp->version = rp->msg.version;
+			if (rp->msg.type == MESSAGE_SERVER_STATE_UPDATE && rp->msg.length == sizeof(msg_srv_state))
+				rp->base = rp->msg.body.state;
+			rp->at += (u64)dt * 1000;
+			return 1;
+		case _ENTRY_DELTA:
+			state = &rp->base;
+			if (!_take(rp, &mask, sizeof(mask))
+				|| (mask & _DELTA_P1 && !_take(rp, &state->p1_paddle, sizeof(f32)))
+				|| (mask & _DELTA_P2 && !_take(rp, &state->p2_paddle, sizeof(f32)))
+				|| (mask & _DELTA_BALL_X && !_take(rp, &state->ball.x, sizeof(f32)))
+				|| (mask & _DELTA_BALL_Y && !_take(rp, &state->ball.y, sizeof(f32)))
+				|| (mask & _DELTA_SCORE && !_take(rp, &state->score, sizeof(u16))))
+				break ;
+			rp->msg = (message){
+				.version = rp->version,
+				.type = MESSAGE_SERVER_STATE_UPDATE,
+				.length = sizeof(msg_srv_state)
+			};
+			rp->msg.body.state = *state;
+			rp->at += (u64)dt * 1000;
+			return 1;
+	}
+	rp->pos = pos;
+	return 0;
+}
+
+static u8	_take(replay *rp, void *out, const size_t n) {
+	if (rp->end - rp->pos < n)
+		return 0;
+	memcpy(out, &rp->map[rp->pos], n);
+	rp->pos += n;
+	return 1;
+}
+
+// a writer that never reached record_close left no footer, so every raw state becomes a key
+static void	_scan_index(replay *rp) {
+	record_key	*index;
+	size_t		pos;
+	u32			cap;
+
+	rp->pos = _FILE_HEADER_SIZE;
+	rp->at = 0;
+	for (cap = 0, pos = rp->pos; _decode(rp); pos = rp->pos) {
+		if (rp->map[pos + sizeof(u32)] != _ENTRY_RAW || rp->msg.type != MESSAGE_SERVER_STATE_UPDATE
+			|| rp->msg.length != sizeof(msg_srv_state))
+			continue ;
+		if (rp->index_count == cap) {
+			cap = (cap) ? cap * 2 : _INDEX_INITIAL_CAP;
+			index = realloc(rp->scanned, cap * sizeof(*index));
+			if (!index)
+				break ;
+			rp->scanned = index;
+		}
+		rp->scanned[rp->index_count++] = (record_key){
+			.at = rp->at / 1000,
+			.offset = pos
+		};
+	}
+	rp->index = rp->scanned;
+}
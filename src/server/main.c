@@ -0,0 +1,138 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<main.c>>
+
+#include <errno.h>
+#include <stdio.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "net.h"
+#include "mock.h"
+
+#define _RATE_DEFAULT	60
+
+static inline u8	_parse_stall(mock_config *config, const char *arg);
+static inline u8	_parse_num(const char *arg, const u64 max, u64 *n);
+static inline void	_stop_sig(i32 sig);
+static inline i32	_usage(const char *name);
+
+static mock_server	srv;
+
+int	main(i32 ac, char **av) {
+	struct sigaction	action;
+	mock_config			config;
+	const char			*args[2];
+	u64					games;
+	u64					tmp;
+	u16					port;
+	u8					loop;
+	i32					n;
+	i32					i;
+
+	config = (mock_config){.rate = _RATE_DEFAULT, .version = 1, .pattern = MOCK_PATTERN_STEADY};
+	for (i = 1, n = 0, loop = 0; i < ac; i++) {
+		tmp = 0;
+		if (strcmp(av[i], "--rate") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], 1000000, &tmp) || !tmp)
+				return _usage(av[0]);
+			config.rate = tmp;
+		} else if (strcmp(av[i], "--burst") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], UINT32_MAX, &tmp))
+				return _usage(av[0]);
+			config.burst = tmp;
+			config.pattern = MOCK_PATTERN_BURST;
+		} else if (strcmp(av[i], "--stall") == 0 && i + 1 < ac) {
+			if (!_parse_stall(&config, av[++i]))
+				return _usage(av[0]);
+		} else if (strcmp(av[i], "--close-after") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], UINT32_MAX, &tmp))
+				return _usage(av[0]);
+			config.close_after = tmp;
+		} else if (strcmp(av[i], "--score") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], UINT8_MAX, &tmp))
+				return _usage(av[0]);
+			config.max_score = tmp;
+		} else if (strcmp(av[i], "--duration") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], UINT32_MAX, &tmp))
+				return _usage(av[0]);
+			config.duration = tmp;
+		} else if (strcmp(av[i], "--version") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], 2, &tmp))
+				return _usage(av[0]);
+			config.version = tmp;
+		} else if (strcmp(av[i], "--udp") == 0)
+			config.udp = 1;
+		else if (strcmp(av[i], "--loss") == 0 && i + 1 < ac) {
+			if (!_parse_num(av[++i], 99, &tmp))
+				return _usage(av[0]);
+			config.loss = tmp;
+		} else if (strcmp(av[i], "--loop") == 0)
+			loop = 1;
+		else if (av[i][0] == '-' || n == 2)
+			return _usage(av[0]);
+		else
+			args[n++] = av[i];
+	}
+	port = (n == 2) ? net_port(args[1]) : 0;
+	if (!port)
+		return _usage(av[0]);
+	if (!mock_init(&srv, &config, args[0], port)) {
+		fprintf(stderr, "%s: unable to listen on %s:%s\n", av[0], args[0], args[1]);
+		mock_close(&srv);
+		return 1;
+	}
+	action = (struct sigaction){.sa_handler = _stop_sig};
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	action.sa_handler = SIG_IGN;
+	sigaction(SIGPIPE, &action, NULL);
+	fprintf(stdout, "listening on %s:%hu (p1 %hu, p2 %hu)\n", args[0], srv.ports[0], srv.ports[1], srv.ports[2]);
+	for (games = 0; mock_run(&srv); ) {
+		fprintf(stdout, "game %lu: %lu states, score %hhu-%hhu, status %hhu\n",
+			++games, srv.sent, srv.scores[0], srv.scores[1], srv.status);
+		srv.sent = 0;
+		if (!loop)
+			break ;
+	}
+	mock_close(&srv);
+	return 0;
+}
+
+static inline u8	_parse_stall(mock_config *config, const char *arg) {
+	char	*end;
+
+	config->stall_every = strtoul(arg, &end, 10);
+	if (*end != ':')
+		return 0;
+	config->stall_ms = strtoul(end + 1, &end, 10);
+	return (*end == '\0' && config->stall_every && config->stall_ms) ? 1 : 0;
+}
+
+static inline u8	_parse_num(const char *arg, const u64 max, u64 *n) {
+	char	*end;
+
+	if (*arg < '0' || *arg > '9')
+		return 0;
+	errno = 0;
+	*n = strtoul(arg, &end, 10);
+	return (*end == '\0' && errno != ERANGE && *n <= max) ? 1 : 0;
+}
+
+static inline void	_stop_sig(i32 sig) {
+	(void)sig;
+	mock_stop(&srv);
+}
+
+static inline i32	_usage(const char *name) {
+	fprintf(stdout, "Usage: %s address port [--rate N] [--burst N] [--stall EVERY_MS:MS]\n", name);
+	fprintf(stdout, "       %*s [--close-after MS] [--score N] [--duration S] [--version 0|1|2]\n", (i32)strlen(name), "");
+	fprintf(stdout, "       %*s [--udp] [--loss PERCENT] [--loop]\n", (i32)strlen(name), "");
+	return 1;
+}
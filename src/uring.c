@@ -0,0 +1,235 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<uring.c>>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+#define _BUF_GROUP	0
+
+#define _TAG_RECV	0x1UL
+#define _TAG_SEND	0x2UL
+
+#define _TAG_SHIFT	32
+
+#define load_acquire(p)		(__atomic_load_n(p, __ATOMIC_ACQUIRE))
+#define store_release(p, v)	(__atomic_store_n(p, v, __ATOMIC_RELEASE))
+
+static inline i32	_setup(const u32 entries, struct io_uring_params *params);
+static inline i32	_enter(const i32 fd, const u32 to_submit);
+static inline i32	_register(const i32 fd, const u32 opcode, void *arg, const u32 n);
+
+static inline struct io_uring_sqe	*_get_sqe(uring *ring);
+
+static inline void	_provide_buf(uring *ring, const u16 id);
+static inline u8	_arm_recv(uring *ring);
+
+u8	uring_init(uring *ring) {
+	struct io_uring_params	params;
+	struct io_uring_buf_reg	reg;
+	u8						*base;
+	u16						i;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->fd = -1;
+	ring->recv_socket = -1;
+	ring->ring = MAP_FAILED;
+	ring->sq.sqes = MAP_FAILED;
+	ring->bufs.ring = MAP_FAILED;
+	memset(&params, 0, sizeof(params));
+	ring->fd = _setup(URING_ENTRIES, &params);
+	if (ring->fd == -1 || !(params.features & IORING_FEAT_SINGLE_MMAP))
+		return 0;
+	ring->ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	if (params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe) > ring->ring_size)
+		ring->ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	ring->ring = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->ring == MAP_FAILED)
+		return 0;
+	ring->sq.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sq.sqes = mmap(NULL, ring->sq.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sq.sqes == MAP_FAILED)
+		return 0;
+	base = ring->ring;
+	ring->sq.head = (u32 *)&base[params.sq_off.head];
+	ring->sq.tail = (u32 *)&base[params.sq_off.tail];
+	ring->sq.mask = (u32 *)&base[params.sq_off.ring_mask];
+	ring->sq.array = (u32 *)&base[params.sq_off.array];
+	ring->cq.head = (u32 *)&base[params.cq_off.head];
+	ring->cq.tail = (u32 *)&base[params.cq_off.tail];
+	ring->cq.mask = (u32 *)&base[params.cq_off.ring_mask];
+	ring->cq.cqes = (struct io_uring_cqe *)&base[params.cq_off.cqes];
+	ring->bufs.ring = mmap(NULL, URING_BUF_COUNT * (sizeof(struct io_uring_buf) + URING_BUF_SIZE),
+						   PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ring->bufs.ring == MAP_FAILED)
+		return 0;
+	ring->bufs.data = (u8 *)&ring->bufs.ring->bufs[URING_BUF_COUNT];
+	reg = (struct io_uring_buf_reg){
+		.ring_addr = (uintptr_t)ring->bufs.ring,
+		.ring_entries = URING_BUF_COUNT,
+		.bgid = _BUF_GROUP
+	};
+	if (_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) == -1)
+		return 0;
+	ring->registered = 1;
+	for (i = 0; i < URING_BUF_COUNT; i++)
+		_provide_buf(ring, i);
+	return 1;
+}
+
+void	uring_close(uring *ring) {
+	if (ring->bufs.ring != MAP_FAILED)
+		munmap(ring->bufs.ring, URING_BUF_COUNT * (sizeof(struct io_uring_buf) + URING_BUF_SIZE));
+	if (ring->sq.sqes != MAP_FAILED)
+		munmap(ring->sq.sqes, ring->sq.sqes_size);
+	if (ring->ring != MAP_FAILED)
+		munmap(ring->ring, ring->ring_size);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	ring->bufs.ring = MAP_FAILED;
+	ring->sq.sqes = MAP_FAILED;
+	ring->ring = MAP_FAILED;
+	ring->fd = -1;
+}
+
+u8	uring_recv(uring *ring, const i32 socket) {
+	ring->recv_socket = socket;
+	return _arm_recv(ring) && uring_submit(ring);
+}
+
+// only queues the send, uring_submit hands everything queued to the kernel at once
+u8	uring_send(uring *ring, const i32 socket, const void *buf, const size_t n) {
+	struct io_uring_sqe	*sqe;
+	u32					slot;
+
+	if (n > URING_SEND_SLOT_SIZE || ring->send.failed || ring->send.used == UINT32_MAX)
+		return 0;
+	sqe = _get_sqe(ring);
+	if (!sqe)
+		return 0;
+	slot = __builtin_ctz(~ring->send.used);
+	ring->send.used |= 1U << slot;
+	memcpy(ring->send.data[slot], buf, n);
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = socket;
+	sqe->addr = (uintptr_t)ring->send.data[slot];
+	sqe->len = n;
+	sqe->user_data = _TAG_SEND << _TAG_SHIFT | slot;
+	return 1;
+}
+
+u8	uring_submit(uring *ring) {
+	i32	rv;
+
+	if (!ring->queued)
+		return 1;
+	store_release(ring->sq.tail, *ring->sq.tail + ring->queued);
+	do
+		rv = _enter(ring->fd, ring->queued);
+	while (rv == -1 && errno == EINTR);
+	ring->queued = 0;
+	return (rv != -1) ? 1 : 0;
+}
+
+u8	uring_reap(uring *ring, uring_recv_fn fn) {
+	struct io_uring_cqe	*cqe;
+	u32					head;
+	u16					id;
+	u8					rearm;
+	u8					rv;
+
+	rearm = 0;
+	rv = 1;
+	for (head = *ring->cq.head; rv && head != load_acquire(ring->cq.tail); head++) {
+		cqe = &ring->cq.cqes[head & *ring->cq.mask];
+		switch (cqe->user_data >> _TAG_SHIFT) {
+			case _TAG_RECV:
+				// kernels older than 6.0 reject IORING_RECV_MULTISHOT on the first completion
+				if (cqe->res == -EINVAL && !ring->received) {
+					ring->unsupported = 1;
+					break ;
+				}
+				ring->received = 1;
+				if (cqe->flags & IORING_CQE_F_BUFFER) {
+					id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+					rv = fn(&ring->bufs.data[id * URING_BUF_SIZE], cqe->res);
+					_provide_buf(ring, id);
+				} else if (cqe->res != -ENOBUFS)
+					rv = fn(NULL, cqe->res);
+				if (!(cqe->flags & IORING_CQE_F_MORE) && cqe->res != 0)
+					rearm = 1;
+				break ;
+			case _TAG_SEND:
+				if (cqe->res < 0)
+					ring->send.failed = 1;
+				ring->send.used &= ~(1U << (cqe->user_data & 0x1FU));
+		}
+	}
+	store_release(ring->cq.head, head);
+	if (rv && rearm)
+		rv = _arm_recv(ring) && uring_submit(ring);
+	return rv;
+}
+
+static inline i32	_setup(const u32 entries, struct io_uring_params *params) {
+	return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static inline i32	_enter(const i32 fd, const u32 to_submit) {
+	return syscall(__NR_io_uring_enter, fd, to_submit, 0, 0, NULL, 0);
+}
+
+static inline i32	_register(const i32 fd, const u32 opcode, void *arg, const u32 n) {
+	return syscall(__NR_io_uring_register, fd, opcode, arg, n);
+}
+
+static inline struct io_uring_sqe	*_get_sqe(uring *ring) {
+	struct io_uring_sqe	*sqe;
+	u32					tail;
+	u32					index;
+
+	tail = *ring->sq.tail + ring->queued;
+	if (tail - load_acquire(ring->sq.head) > *ring->sq.mask)
+		return NULL;
+	index = tail & *ring->sq.mask;
+	sqe = &ring->sq.sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	ring->sq.array[index] = index;
+	ring->queued++;
+	return sqe;
+}
+
+static inline void	_provide_buf(uring *ring, const u16 id) {
+	struct io_uring_buf	*buf;
+
+	buf = &ring->bufs.ring->bufs[ring->bufs.tail & (URING_BUF_COUNT - 1)];
+	buf->addr = (uintptr_t)&ring->bufs.data[id * URING_BUF_SIZE];
+	buf->len = URING_BUF_SIZE;
+	buf->bid = id;
+	store_release(&ring->bufs.ring->tail, ++ring->bufs.tail);
+}
+
+static inline u8	_arm_recv(uring *ring) {
+	struct io_uring_sqe	*sqe;
+
+	sqe = _get_sqe(ring);
+	if (!sqe)
+		return 0;
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = ring->recv_socket;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = _BUF_GROUP;
+	sqe->user_data = _TAG_RECV << _TAG_SHIFT;
+	return 1;
+}
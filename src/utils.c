@@ -8,6 +8,7 @@
 // <<utils.c>>
 
 #include <math.h>
+#include <time.h>
 #include <stdlib.h>
 
 #include "utils.h"
@@ -32,28 +33,27 @@ char	*utoa16(u16 n, char *buf) {
 	return buf;
 }
 
-i32	fputc_utf8(const u32 cp, FILE *stream) {
-	char	buf[4];
-
+u8	utf8_encode(const u32 cp, char buf[4]) {
 	if (cp <= 0x7FU) {
-		return fputc(cp, stream);
+		buf[0] = cp;
+		return 1;
 	} else if (cp <= 0x7FFU) {
 		buf[0] = (_UTF8_LENGTH_2BS | ((cp & 0x07C0U) >> 6));
 		buf[1] = (_UTF8_BYTE_START | (cp & 0x003FU));
-		return (fwrite(buf, 1, 2, stream) == 2) ? cp : EOF;
+		return 2;
 	} else if (cp <= 0xFFFFU) {
 		buf[0] = (_UTF8_LENGTH_3BS | ((cp & 0xF000U) >> 12));
 		buf[1] = (_UTF8_BYTE_START | ((cp & 0x0FC0U) >> 6));
 		buf[2] = (_UTF8_BYTE_START | (cp & 0x003FU));
-		return (fwrite(buf, 1, 3, stream) == 3) ? cp : EOF;
+		return 3;
 	} else if (cp <= 0x10FFFFU) {
 		buf[0] = (_UTF8_LENGTH_4BS | ((cp & 0x1C0000U) >> 18));
 		buf[1] = (_UTF8_BYTE_START | ((cp & 0x03F000U) >> 12));
 		buf[2] = (_UTF8_BYTE_START | ((cp & 0x000FC0U) >> 6));
 		buf[3] = (_UTF8_BYTE_START | (cp & 0x00003FU));
-		return (fwrite(buf, 1, 4, stream) == 4) ? cp : EOF;
+		return 4;
 	}
-	return EOF;
+	return 0;
 }
 
 f32	roundf_f(const f32 n, const f32 factor) {
@@ -65,6 +65,20 @@ f32	roundf_f(const f32 n, const f32 factor) {
 	return n - remainder;
 }
 
+u64	time_ns(void) {
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+u64	wall_ns(void) {
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (u64)ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
 static inline size_t	_uintlen(u64 n) {
 	size_t	len;
 
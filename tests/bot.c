@@ -0,0 +1,57 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<bot.c>>
+
+#include "bot.h"
+#include "check.h"
+
+static inline u8	_steer(const u8 side, const f32 from[2], const f32 to[2], const f32 paddle);
+
+int	main(void) {
+	msg_srv_state	state;
+	bot				pilot;
+
+	// nothing to extrapolate from yet, so hold the middle
+	bot_init(&pilot, 1);
+	state = (msg_srv_state){.p1_paddle = 10.0f, .p2_paddle = 10.0f, .ball = {20.0f, 3.0f}};
+	check(!bot_update(&pilot, &state) && pilot.direction == BOT_STOP);
+	state.p2_paddle = 4.0f;
+	check(bot_update(&pilot, &state) && pilot.direction == BOT_UP);
+	check(!bot_update(&pilot, &state));
+	// a flat shot is met where it is
+	check(_steer(1, (f32 [2]){20.0f, 5.0f}, (f32 [2]){21.0f, 5.0f}, 10.0f) == BOT_DOWN);
+	check(_steer(1, (f32 [2]){20.0f, 5.0f}, (f32 [2]){21.0f, 5.0f}, 5.3f) == BOT_STOP);
+	// off the bottom wall: 19 + 9 = 28 folds back to 12
+	check(_steer(1, (f32 [2]){30.0f, 18.0f}, (f32 [2]){31.0f, 19.0f}, 12.0f) == BOT_STOP);
+	check(_steer(1, (f32 [2]){30.0f, 18.0f}, (f32 [2]){31.0f, 19.0f}, 5.0f) == BOT_UP);
+	check(_steer(1, (f32 [2]){30.0f, 18.0f}, (f32 [2]){31.0f, 19.0f}, 18.0f) == BOT_DOWN);
+	// off the top wall toward p1: 1 - 9 = -8 folds back to 8
+	check(_steer(0, (f32 [2]){10.0f, 2.0f}, (f32 [2]){9.0f, 1.0f}, 8.0f) == BOT_STOP);
+	check(_steer(0, (f32 [2]){10.0f, 2.0f}, (f32 [2]){9.0f, 1.0f}, 14.0f) == BOT_DOWN);
+	// off both walls: 6 + 39 = 45 folds back to 5
+	check(_steer(1, (f32 [2]){0.0f, 5.0f}, (f32 [2]){1.0f, 6.0f}, 5.0f) == BOT_STOP);
+	check(_steer(1, (f32 [2]){0.0f, 5.0f}, (f32 [2]){1.0f, 6.0f}, 15.0f) == BOT_DOWN);
+	// a ball going away or a serve jump sends the paddle back to the middle
+	check(_steer(1, (f32 [2]){21.0f, 2.0f}, (f32 [2]){20.0f, 2.0f}, 2.0f) == BOT_UP);
+	check(_steer(0, (f32 [2]){39.0f, 2.0f}, (f32 [2]){10.0f, 2.0f}, 2.0f) == BOT_UP);
+	return check_done();
+}
+
+// the direction the pilot picks after seeing the ball move between two states
+static inline u8	_steer(const u8 side, const f32 from[2], const f32 to[2], const f32 paddle) {
+	msg_srv_state	state;
+	bot				pilot;
+
+	bot_init(&pilot, side);
+	state = (msg_srv_state){.p1_paddle = paddle, .p2_paddle = paddle, .ball = {from[0], from[1]}};
+	bot_update(&pilot, &state);
+	state.ball.x = to[0];
+	state.ball.y = to[1];
+	bot_update(&pilot, &state);
+	return pilot.direction;
+}
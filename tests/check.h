@@ -0,0 +1,21 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<check.h>>
+
+#pragma once
+
+#include <stdio.h>
+
+#include "data.h"
+
+static u32	check_failures;
+
+// reports the failing expression and keeps going so one run shows every failure
+#define check(cond)	((cond) ? 1 : (fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond), check_failures++, 0))
+
+#define check_done()	((check_failures) ? (fprintf(stderr, "%s: %u failed\n", __FILE__, check_failures), 1) : 0)
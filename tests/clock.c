@@ -0,0 +1,62 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<clock.c>>
+
+#include "net.h"
+#include "check.h"
+
+#define _MS		1000000ULL
+#define _SKEW	(250 * _MS)
+
+static inline u8	_exchange(net_clock *clock, const u64 sent, const u64 up, const u64 hold, const u64 down);
+
+int	main(void) {
+	static net_clock	clock;
+	msg_srv_pong		pong;
+	u64					t;
+	u32					i;
+
+	net_clock_reset(&clock);
+	// replies that cannot come from this ping are refused
+	pong = (msg_srv_pong){.sent = 100 * _MS, .received = 50 * _MS, .replied = 49 * _MS};
+	check(!net_clock_sample(&clock, &pong, 101 * _MS));
+	pong = (msg_srv_pong){.sent = 100 * _MS, .received = 50 * _MS, .replied = 60 * _MS};
+	check(!net_clock_sample(&clock, &pong, 99 * _MS));
+	check(!net_clock_sample(&clock, &pong, 105 * _MS));
+	check(clock.samples == 0);
+	// the server's hold time is not part of the rtt, and a symmetric path gives the exact offset
+	t = 1000 * _MS;
+	check(_exchange(&clock, t, 5 * _MS, 3 * _MS, 5 * _MS));
+	check(clock.rtt == 10 * _MS && clock.rtt_var == 5 * _MS);
+	check(clock.offset == (i64)_SKEW);
+	// slower exchanges with queueing on the way back skew their offset, the fastest one is kept
+	for (i = 1; i < NET_CLOCK_WINDOW; i++) {
+		t += 100 * _MS;
+		check(_exchange(&clock, t, 5 * _MS, 0, 25 * _MS));
+		check(clock.offset == (i64)_SKEW);
+	}
+	check(clock.rtt > 10 * _MS && clock.rtt < 30 * _MS);
+	// once the fast exchange leaves the window the best of what is left is used
+	t += 100 * _MS;
+	check(_exchange(&clock, t, 5 * _MS, 0, 25 * _MS));
+	check(clock.offset == (i64)_SKEW - 10 * (i64)_MS);
+	check(clock.samples == NET_CLOCK_WINDOW + 1);
+	return check_done();
+}
+
+// the server clock runs _SKEW ahead of ours
+static inline u8	_exchange(net_clock *clock, const u64 sent, const u64 up, const u64 hold, const u64 down) {
+	msg_srv_pong	pong;
+
+	pong = (msg_srv_pong){
+		.sent = sent,
+		.received = sent + up + _SKEW,
+		.replied = sent + up + hold + _SKEW
+	};
+	return net_clock_sample(clock, &pong, sent + up + hold + down);
+}
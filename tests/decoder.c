@@ -0,0 +1,190 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<decoder.c>>
+
+#include <string.h>
+
+#include "net.h"
+#include "check.h"
+
+static inline void	_feed(net_rx *rx, const void *data, const size_t n);
+static inline size_t	_put(u8 *out, const u8 type, const u16 length, const void *body, const size_t size);
+static inline void	_unknown_type(void);
+static inline void	_zero_length(void);
+static inline void	_split(void);
+static inline void	_expand_delta(void);
+static inline void	_bad_v2_size(void);
+
+int	main(void) {
+	_unknown_type();
+	_zero_length();
+	_split();
+	_expand_delta();
+	_bad_v2_size();
+	return check_done();
+}
+
+static inline void	_feed(net_rx *rx, const void *data, const size_t n) {
+	size_t	room;
+	u8		*buf;
+
+	buf = net_rx_space(rx, &room);
+	if (!check(room >= n))
+		return ;
+	memcpy(buf, data, n);
+	net_rx_commit(rx, n);
+}
+
+static inline size_t	_put(u8 *out, const u8 type, const u16 length, const void *body, const size_t size) {
+	message	hdr;
+
+	hdr = (message){.version = NET_PROTOCOL_VERSION, .type = type, .length = length};
+	memcpy(out, &hdr, MESSAGE_HEADER_SIZE);
+	memcpy(&out[MESSAGE_HEADER_SIZE], body, size);
+	return MESSAGE_HEADER_SIZE + size;
+}
+
+// a type this client does not know is skipped by its length, even when the body straddles reads
+static inline void	_unknown_type(void) {
+	static net_rx	rx;
+	const message	*msg;
+	msg_srv_pong	pong;
+	u8				junk[40];
+	u8				buf[sizeof(junk) + 2 * sizeof(message)];
+	size_t			n;
+
+	net_rx_reset(&rx);
+	memset(junk, MESSAGE_SERVER_STATE_UPDATE, sizeof(junk));
+	pong = (msg_srv_pong){.sent = 1, .received = 2, .replied = 3};
+	n = _put(buf, 0x7F, sizeof(junk), junk, sizeof(junk));
+	n += _put(&buf[n], MESSAGE_SERVER_PONG, sizeof(pong), &pong, sizeof(pong));
+	_feed(&rx, buf, 10);
+	check(net_rx_next(&rx, NET_PROTOCOL_VERSION) == NULL);
+	check(rx.skip == sizeof(junk) - (10 - MESSAGE_HEADER_SIZE));
+	_feed(&rx, &buf[10], n - 10);
+	msg = net_rx_next(&rx, NET_PROTOCOL_VERSION);
+	if (check(msg != NULL)) {
+		check(msg->type == MESSAGE_SERVER_PONG);
+		check(msg->body.pong.sent == 1 && msg->body.pong.received == 2 && msg->body.pong.replied == 3);
+	}
+	check(net_rx_next(&rx, NET_PROTOCOL_VERSION) == NULL);
+}
+
+// length zero from an old server falls back to the known body size
+static inline void	_zero_length(void) {
+	static net_rx	rx;
+	const message	*msg;
+	msg_srv_state	state;
+	msg_srv_init	init;
+	u8				buf[2 * sizeof(message)];
+	size_t			n;
+
+	net_rx_reset(&rx);
+	state = (msg_srv_state){.p1_paddle = 0.25f, .p2_paddle = 0.75f, .ball = {0.5f, 0.125f}, .score = 0x0102};
+	init = (msg_srv_init){.p1_port = 4243, .p2_port = 4244};
+	n = _put(buf, MESSAGE_SERVER_STATE_UPDATE, 0, &state, sizeof(state));
+	n += _put(&buf[n], MESSAGE_SERVER_GAME_INIT, 0, &init, MESSAGE_SERVER_INIT_SIZE);
+	_feed(&rx, buf, n);
+	msg = net_rx_next(&rx, 1);
+	if (check(msg != NULL) && check(msg->type == MESSAGE_SERVER_STATE_UPDATE))
+		check(memcmp(&msg->body.state, &state, sizeof(state)) == 0);
+	msg = net_rx_next(&rx, 1);
+	if (check(msg != NULL) && check(msg->type == MESSAGE_SERVER_GAME_INIT)) {
+		net_init_body(msg, &init);
+		check(init.p1_port == 4243 && init.p2_port == 4244 && init.udp_port == 0);
+	}
+	check(net_rx_next(&rx, 1) == NULL);
+	check(rx.head == rx.tail);
+}
+
+// a message cut at every byte boundary only comes out once it is whole
+static inline void	_split(void) {
+	static net_rx	rx;
+	const message	*msg;
+	msg_srv_state	state;
+	u8				buf[sizeof(message)];
+	size_t			n;
+	size_t			i;
+
+	net_rx_reset(&rx);
+	state = (msg_srv_state){.p1_paddle = -1.0f, .p2_paddle = 1.0f, .ball = {2.0f, 3.0f}, .score = 7};
+	n = _put(buf, MESSAGE_SERVER_STATE_UPDATE, sizeof(state), &state, sizeof(state));
+	for (i = 0; i < n - 1; i++) {
+		_feed(&rx, &buf[i], 1);
+		check(net_rx_next(&rx, 1) == NULL);
+	}
+	_feed(&rx, &buf[n - 1], 1);
+	msg = net_rx_next(&rx, 1);
+	if (check(msg != NULL))
+		check(memcmp(&msg->body.state, &state, sizeof(state)) == 0);
+}
+
+// a v2 delta only carries the flagged fields, the rest come from the previous state
+static inline void	_expand_delta(void) {
+	static net_rx	rx;
+	const message	*msg;
+	u8				body[sizeof(msg_srv_state_v2)];
+	u8				buf[2 * sizeof(message)];
+	i16				q[4];
+	u16				score;
+	size_t			n;
+
+	net_rx_reset(&rx);
+	q[0] = 64;
+	q[1] = -128;
+	q[2] = 512;
+	q[3] = 256;
+	score = 0x0305;
+	body[0] = STATE_V2_ALL;
+	memcpy(&body[1], q, sizeof(q));
+	memcpy(&body[1 + sizeof(q)], &score, sizeof(score));
+	n = _put(buf, MESSAGE_SERVER_STATE_UPDATE, sizeof(body), body, sizeof(body));
+	q[0] = -64;
+	body[0] = STATE_V2_P2 | STATE_V2_BALL_Y;
+	memcpy(&body[1], &q[0], sizeof(*q));
+	memcpy(&body[1 + sizeof(*q)], &q[0], sizeof(*q));
+	n += _put(&buf[n], MESSAGE_SERVER_STATE_UPDATE, 1 + 2 * sizeof(*q), body, 1 + 2 * sizeof(*q));
+	_feed(&rx, buf, n);
+	msg = net_rx_next(&rx, 2);
+	if (check(msg != NULL) && check(msg->length == sizeof(msg_srv_state))) {
+		check(msg->body.state.p1_paddle == 0.25f && msg->body.state.p2_paddle == -0.5f);
+		check(msg->body.state.ball.x == 2.0f && msg->body.state.ball.y == 1.0f);
+		check(msg->body.state.score == 0x0305);
+	}
+	msg = net_rx_next(&rx, 2);
+	if (check(msg != NULL)) {
+		check(msg->body.state.p1_paddle == 0.25f && msg->body.state.p2_paddle == -0.25f);
+		check(msg->body.state.ball.x == 2.0f && msg->body.state.ball.y == -0.25f);
+		check(msg->body.state.score == 0x0305);
+	}
+}
+
+// a v2 state whose length disagrees with its flags is dropped without touching the base
+static inline void	_bad_v2_size(void) {
+	static net_rx	rx;
+	const message	*msg;
+	msg_srv_pong	pong;
+	u8				body[sizeof(msg_srv_state_v2)];
+	u8				buf[2 * sizeof(message)];
+	i16				q;
+	size_t			n;
+
+	net_rx_reset(&rx);
+	rx.base.p1_paddle = 1.5f;
+	q = 256;
+	body[0] = STATE_V2_P1 | STATE_V2_P2;
+	memcpy(&body[1], &q, sizeof(q));
+	pong = (msg_srv_pong){.sent = 9};
+	n = _put(buf, MESSAGE_SERVER_STATE_UPDATE, 1 + sizeof(q), body, 1 + sizeof(q));
+	n += _put(&buf[n], MESSAGE_SERVER_PONG, sizeof(pong), &pong, sizeof(pong));
+	_feed(&rx, buf, n);
+	msg = net_rx_next(&rx, 2);
+	if (check(msg != NULL))
+		check(msg->type == MESSAGE_SERVER_PONG && msg->body.pong.sent == 9);
+	check(rx.base.p1_paddle == 1.5f);
+}
@@ -0,0 +1,109 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<jitter.c>>
+
+#include "jitter.h"
+#include "check.h"
+
+#define _MS	1000000ULL
+
+static inline game	_state(const u32 i);
+static inline void	_steady(void);
+static inline void	_jittery(void);
+static inline void	_score(void);
+
+int	main(void) {
+	_steady();
+	_jittery();
+	_score();
+	return check_done();
+}
+
+static inline game	_state(const u32 i) {
+	return (game){.p1_pos = i, .p2_pos = -(f32)i, .ball = {(f32)i, 1.0f}};
+}
+
+// an even stream is played one interval behind, interpolated between states
+static inline void	_steady(void) {
+	static jitter_buffer	buf;
+	game					state;
+	game					frame;
+	u64						now;
+	u32						i;
+
+	jitter_init(&buf, JITTER_MAX_DELAY_DEFAULT * _MS);
+	check(!jitter_sample(&buf, &frame, 1000 * _MS));
+	for (i = 0, now = 1000 * _MS; i < 32; i++, now += 16 * _MS) {
+		state = _state(i);
+		jitter_push(&buf, &state, now);
+	}
+	now -= 16 * _MS;
+	check(buf.interval == 16 * _MS && buf.jitter == 0 && buf.delay == 16 * _MS);
+	// half an interval past the state before the newest
+	check(jitter_sample(&buf, &frame, now + 8 * _MS));
+	check(frame.ball.x == 30.5f && frame.p1_pos == 30.5f && frame.p2_pos == -30.5f && frame.ball.y == 1.0f);
+	// a silence longer than a stall starts a new timeline
+	now += 300 * _MS;
+	state = _state(100);
+	jitter_push(&buf, &state, now);
+	check(buf.count == 1);
+	check(!jitter_sample(&buf, &frame, now) && frame.ball.x == 100.0f);
+}
+
+// uneven arrivals grow the delay up to the cap, and playback never runs backwards
+static inline void	_jittery(void) {
+	static jitter_buffer	capped;
+	static jitter_buffer	buf;
+	game					state;
+	game					frame;
+	u64						now;
+	u64						next;
+	u64						playout;
+	f32						last;
+	u8						ordered;
+	u32						i;
+
+	jitter_init(&buf, JITTER_MAX_DELAY_DEFAULT * _MS);
+	jitter_init(&capped, 20 * _MS);
+	for (i = 0, now = 1000 * _MS, next = now, playout = 0, last = 0.0f, ordered = 1; i < 200; now += _MS) {
+		if (now >= next) {
+			state = _state(i);
+			jitter_push(&buf, &state, now);
+			jitter_push(&capped, &state, now);
+			next += (i++ % 2) ? 28 * _MS : 4 * _MS;
+		}
+		// the newest state is the frame once playback catches up, so the result is not checked
+		jitter_sample(&buf, &frame, now);
+		if (frame.ball.x < last || buf.playout < playout)
+			ordered = 0;
+		last = frame.ball.x;
+		playout = buf.playout;
+	}
+	check(ordered);
+	check(buf.delay > 32 * _MS && buf.delay <= JITTER_MAX_DELAY_DEFAULT * _MS);
+	check(capped.delay == 20 * _MS);
+}
+
+// a point scored in between is shown as is rather than blended
+static inline void	_score(void) {
+	static jitter_buffer	buf;
+	game					state;
+	game					frame;
+
+	jitter_init(&buf, JITTER_MAX_DELAY_DEFAULT * _MS);
+	state = _state(0);
+	jitter_push(&buf, &state, 1000 * _MS);
+	state = _state(10);
+	state.p2_score = 1;
+	jitter_push(&buf, &state, 1016 * _MS);
+	state = _state(20);
+	state.p2_score = 1;
+	jitter_push(&buf, &state, 1032 * _MS);
+	check(jitter_sample(&buf, &frame, 1024 * _MS));
+	check(frame.ball.x == 0.0f && frame.p2_score == 0);
+}
@@ -0,0 +1,98 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<queue.c>>
+
+#include <sched.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "queue.h"
+#include "check.h"
+
+#define _PRODUCERS	4
+#define _PUSHES		20000
+
+static cmd_queue	_queue;
+
+static inline void	_fifo(void);
+static inline void	_producers(void);
+static void			*_produce(void *arg);
+
+int	main(void) {
+	_fifo();
+	_producers();
+	return check_done();
+}
+
+// holds exactly QUEUE_SIZE commands and hands them back in order, many times around the ring
+static inline void	_fifo(void) {
+	command	cmd;
+	u32		round;
+	u32		i;
+
+	queue_init(&_queue);
+	check(!queue_pop(&_queue, &cmd));
+	for (round = 0; round < 3; round++) {
+		for (i = 0; i < QUEUE_SIZE; i++) {
+			cmd = (command){.player = i % 2, .msg = {.type = MESSAGE_CLIENT_MOVE_PADDLE, .length = round}};
+			cmd.msg.body.move_paddle.direction = i;
+			check(queue_push(&_queue, &cmd));
+		}
+		check(!queue_push(&_queue, &cmd));
+		for (i = 0; i < QUEUE_SIZE; i++)
+			check(queue_pop(&_queue, &cmd) && cmd.player == i % 2 && cmd.msg.length == round
+				&& cmd.msg.body.move_paddle.direction == (u8)i);
+		check(!queue_pop(&_queue, &cmd));
+	}
+}
+
+// every push from every producer comes out once, and each producer's pushes stay in order
+static inline void	_producers(void) {
+	pthread_t	tids[_PRODUCERS];
+	command		cmd;
+	u32			next[_PRODUCERS] = {0};
+	u32			seq;
+	u32			total;
+	u8			ordered;
+	u8			i;
+
+	queue_init(&_queue);
+	for (i = 0; i < _PRODUCERS; i++)
+		if (!check(pthread_create(&tids[i], NULL, _produce, (void *)(uintptr_t)i) == 0))
+			return ;
+	for (total = 0, ordered = 1; total < _PRODUCERS * _PUSHES; ) {
+		// yield so a single core still lets the producers run
+		if (!queue_pop(&_queue, &cmd)) {
+			sched_yield();
+			continue ;
+		}
+		memcpy(&seq, &cmd.msg.body, sizeof(seq));
+		if (cmd.player >= _PRODUCERS || seq != next[cmd.player]++)
+			ordered = 0;
+		total++;
+	}
+	for (i = 0; i < _PRODUCERS; i++)
+		pthread_join(tids[i], NULL);
+	check(ordered);
+	for (i = 0; i < _PRODUCERS; i++)
+		check(next[i] == _PUSHES);
+	check(!queue_pop(&_queue, &cmd));
+}
+
+static void	*_produce(void *arg) {
+	command	cmd;
+	u32		seq;
+
+	cmd = (command){.player = (uintptr_t)arg, .msg = {.type = MESSAGE_CLIENT_MOVE_PADDLE}};
+	for (seq = 0; seq < _PUSHES; seq++) {
+		memcpy(&cmd.msg.body, &seq, sizeof(seq));
+		while (!queue_push(&_queue, &cmd))
+			sched_yield();
+	}
+	return NULL;
+}
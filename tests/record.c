@@ -0,0 +1,144 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<record.c>>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "record.h"
+#include "check.h"
+
+#define _STATES	300
+
+static inline message	_state(const u32 i);
+static inline void		_record(const char *path);
+static inline void		_round_trip(replay *rp);
+static inline void		_torn_copy(const char *from, const char *to, const size_t size);
+
+int	main(void) {
+	char	full[] = "/tmp/netpong-record-XXXXXX";
+	char	torn[] = "/tmp/netpong-record-XXXXXX";
+	replay	a;
+	replay	b;
+	message	want;
+	u64		at;
+	u32		i;
+
+	if (!check(close(mkstemp(full)) == 0 && close(mkstemp(torn)) == 0))
+		return check_done();
+	_record(full);
+	if (check(replay_open(&a, full))) {
+		// a keyframe opens the stream and then one every RECORD_KEYFRAME_INTERVAL states
+		check(a.index != NULL && a.scanned == NULL);
+		check(a.index_count == (_STATES + RECORD_KEYFRAME_INTERVAL - 1) / RECORD_KEYFRAME_INTERVAL);
+		for (i = 1; i < a.index_count; i++)
+			check(a.index[i].at >= a.index[i - 1].at && a.index[i].offset > a.index[i - 1].offset);
+		_round_trip(&a);
+		// a crashed writer leaves no footer and a torn last entry, the index is rebuilt by scanning
+		_torn_copy(full, torn, a.end + 3);
+		if (check(replay_open(&b, torn))) {
+			check(b.scanned != NULL && b.index_count == a.index_count);
+			for (i = 0; i < a.index_count && i < b.index_count; i++)
+				check(a.index[i].at == b.index[i].at && a.index[i].offset == b.index[i].offset);
+			replay_seek(&b, 0);
+			check(replay_peek(&b, &at) != NULL && b.msg.type == MESSAGE_SERVER_STATE_UPDATE && b.msg.body.state.ball.x == 0);
+			replay_close(&b);
+		}
+		// seeking lands on the last keyframe at or before the target
+		for (i = 0; i < a.index_count; i++) {
+			replay_seek(&a, a.index[i].at * 1000 + 1);
+			want = _state(i * RECORD_KEYFRAME_INTERVAL);
+			if (check(replay_peek(&a, &at) != NULL)) {
+				check(at == a.index[i].at * 1000);
+				check(memcmp(&a.msg.body.state, &want.body.state, sizeof(msg_srv_state)) == 0);
+			}
+		}
+		// nothing before the first state, so GAME_INIT is not fed twice
+		replay_seek(&a, 0);
+		check(replay_peek(&a, &at) != NULL && a.msg.type == MESSAGE_SERVER_STATE_UPDATE && at == a.index[0].at * 1000);
+		replay_close(&a);
+	}
+	unlink(full);
+	unlink(torn);
+	return check_done();
+}
+
+static inline message	_state(const u32 i) {
+	message	msg;
+
+	msg = (message){.version = 1, .type = MESSAGE_SERVER_STATE_UPDATE, .length = sizeof(msg_srv_state)};
+	msg.body.state = (msg_srv_state){
+		.p1_paddle = (i % 7) / 8.0f,
+		.p2_paddle = -(f32)(i % 3),
+		.ball = {(f32)i, i / 3.0f},
+		.score = i / 50
+	};
+	return msg;
+}
+
+static inline void	_record(const char *path) {
+	recorder	rec;
+	message		msg;
+	u32			i;
+
+	if (!check(record_open(&rec, path)))
+		return ;
+	msg = (message){.version = 1, .type = MESSAGE_SERVER_GAME_INIT, .length = MESSAGE_SERVER_INIT_SIZE};
+	msg.body.init = (msg_srv_init){.p1_port = 4243, .p2_port = 4244};
+	record_push(&rec, &msg);
+	for (i = 0; i < _STATES; i++) {
+		msg = _state(i);
+		record_push(&rec, &msg);
+		usleep(50);
+	}
+	check(rec.dropped == 0);
+	record_close(&rec);
+}
+
+// delta entries must decode back to exactly what was pushed, with timestamps never going back
+static inline void	_round_trip(replay *rp) {
+	const message	*msg;
+	message			want;
+	u64				at;
+	u64				last;
+	u32				i;
+
+	msg = replay_peek(rp, &at);
+	if (!check(msg != NULL && msg->type == MESSAGE_SERVER_GAME_INIT))
+		return ;
+	check(msg->body.init.p1_port == 4243 && msg->body.init.p2_port == 4244);
+	replay_skip(rp);
+	for (i = 0, last = 0; (msg = replay_peek(rp, &at)); i++) {
+		want = _state(i);
+		check(msg->type == MESSAGE_SERVER_STATE_UPDATE && msg->length == sizeof(msg_srv_state));
+		check(memcmp(&msg->body.state, &want.body.state, sizeof(msg_srv_state)) == 0);
+		check(at >= last);
+		last = at;
+		replay_skip(rp);
+	}
+	check(i == _STATES);
+}
+
+static inline void	_torn_copy(const char *from, const char *to, const size_t size) {
+	FILE	*in;
+	FILE	*out;
+	u8		*buf;
+
+	buf = malloc(size);
+	in = fopen(from, "rb");
+	out = fopen(to, "wb");
+	if (check(buf && in && out))
+		check(fread(buf, 1, size, in) == size && fwrite(buf, 1, size, out) == size);
+	if (in)
+		fclose(in);
+	if (out)
+		fclose(out);
+	free(buf);
+}
@@ -0,0 +1,111 @@
+// ███████╗████████╗     ██████╗ ██╗   ██╗████████╗ ██████╗██╗  ██╗ █████╗ ██████╗
+// ██╔════╝╚══██╔══╝     ██╔══██╗██║   ██║╚══██╔══╝██╔════╝██║  ██║██╔══██╗██╔══██╗
+// █████╗     ██║        ██████╔╝██║   ██║   ██║   ██║     ███████║███████║██████╔╝
+// ██╔══╝     ██║        ██╔═══╝ ██║   ██║   ██║   ██║     ██╔══██║██╔══██║██╔══██╗
+// ██║        ██║███████╗██║     ╚██████╔╝   ██║   ╚██████╗██║  ██║██║  ██║██║  ██║
+// ╚═╝        ╚═╝╚══════╝╚═╝      ╚═════╝    ╚═╝    ╚═════╝╚═╝  ╚═╝╚═╝  ╚═╝╚═╝  ╚═╝
+//
+// <<udp.c>>
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "net.h"
+#include "check.h"
+
+static inline u8	_send(const i32 socket, const u32 seq, const u8 version, const u8 flags);
+static inline u8	_next(net_udp *udp, const u8 version, u32 *seq);
+static inline void	_wrap(void);
+static inline void	_deltas(void);
+
+int	main(void) {
+	_wrap();
+	_deltas();
+	return check_done();
+}
+
+// a v2 state carries every field, or only the flagged ones for a delta
+static inline u8	_send(const i32 socket, const u32 seq, const u8 version, const u8 flags) {
+	u8		buf[MESSAGE_UDP_SEQ_SIZE + sizeof(message)];
+	message	msg;
+	size_t	size;
+	u8		i;
+
+	msg = (message){.version = version, .type = MESSAGE_SERVER_STATE_UPDATE};
+	if (version >= 2) {
+		msg.body.state_v2.flags = flags;
+		memset(msg.body.state_v2.fields, 0, sizeof(msg.body.state_v2.fields));
+		for (i = 0, size = sizeof(flags); i < 4; i++)
+			if (flags & (1U << i))
+				size += sizeof(i16);
+		if (flags & STATE_V2_SCORE)
+			size += sizeof(u16);
+	} else {
+		msg.body.state = (msg_srv_state){.score = seq & 0xFFFF};
+		size = sizeof(msg_srv_state);
+	}
+	msg.length = size;
+	memcpy(buf, &seq, sizeof(seq));
+	memcpy(&buf[MESSAGE_UDP_SEQ_SIZE], &msg, MESSAGE_HEADER_SIZE + size);
+	size += MESSAGE_UDP_SEQ_SIZE + MESSAGE_HEADER_SIZE;
+	return (send(socket, buf, size, 0) == (ssize_t)size) ? 1 : 0;
+}
+
+static inline u8	_next(net_udp *udp, const u8 version, u32 *seq) {
+	if (!net_udp_next(udp, version))
+		return 0;
+	*seq = udp->seq;
+	return 1;
+}
+
+// sequence numbers keep counting across the u32 wrap, stale and duplicate datagrams are dropped
+static inline void	_wrap(void) {
+	static net_udp	udp;
+	const u32		seqs[] = {0xFFFFFFFEU, 0xFFFFFFFFU, 0xFFFFFFFFU, 0, 0xFFFFFFFDU, 1, 0, 0x80000001U};
+	i32				pair[2];
+	u32				seq;
+	u32				i;
+
+	if (!check(socketpair(AF_UNIX, SOCK_DGRAM, 0, pair) == 0))
+		return ;
+	net_rx_reset(&udp.rx);
+	udp.socket = pair[0];
+	udp.primed = 0;
+	udp.dropped = 0;
+	for (i = 0; i < sizeof(seqs) / sizeof(*seqs); i++)
+		check(_send(pair[1], seqs[i], 1, 0));
+	check(_next(&udp, 1, &seq) && seq == 0xFFFFFFFEU);
+	check(_next(&udp, 1, &seq) && seq == 0xFFFFFFFFU);
+	check(_next(&udp, 1, &seq) && seq == 0);
+	check(_next(&udp, 1, &seq) && seq == 1);
+	// more than half the space ahead reads as behind
+	check(!_next(&udp, 1, &seq));
+	check(udp.seq == 1 && udp.dropped == 4);
+	net_udp_close(&udp);
+	close(pair[1]);
+}
+
+// without an ack a delta could be applied to the wrong base, so only full v2 states are taken
+static inline void	_deltas(void) {
+	static net_udp	udp;
+	i32				pair[2];
+	u32				seq;
+
+	if (!check(socketpair(AF_UNIX, SOCK_DGRAM, 0, pair) == 0))
+		return ;
+	net_rx_reset(&udp.rx);
+	udp.socket = pair[0];
+	udp.primed = 0;
+	udp.dropped = 0;
+	check(_send(pair[1], 10, 2, STATE_V2_ALL));
+	check(_send(pair[1], 11, 2, STATE_V2_P1 | STATE_V2_BALL_X));
+	check(_send(pair[1], 12, 2, STATE_V2_ALL & ~STATE_V2_SCORE));
+	check(_send(pair[1], 13, 2, STATE_V2_ALL));
+	check(_next(&udp, 2, &seq) && seq == 10);
+	check(_next(&udp, 2, &seq) && seq == 13);
+	check(!_next(&udp, 2, &seq));
+	check(udp.dropped == 2);
+	net_udp_close(&udp);
+	close(pair[1]);
+}